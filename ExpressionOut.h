@@ -0,0 +1,145 @@
+// Coalesced forwarding of pitch bend and aftertouch
+//
+// Controllers can send bend and pressure at hundreds of messages a second, more than the
+// DIN port can carry next to the notes. Each stream keeps only its newest value and is
+// sent at most once every EXPR_MIN_INTERVAL_US, the last value always goes out once the
+// interval has passed so the VST finishes where the controller did.
+// Streams are per channel for bend and channel pressure, per channel for poly pressure
+// with every note that changed sent together.
+// A note on or off flushes what its channel is holding first, bend and channel pressure
+// and the poly pressure of that note, so a note never overtakes an earlier bend recentre.
+
+#define EXPR_MIN_INTERVAL_US 4000  // 250 updates a second per stream
+
+#define MIDI_STATUS_POLY_PRESSURE 0xA0
+#define MIDI_STATUS_CHANNEL_PRESSURE 0xD0
+#define MIDI_STATUS_PITCH_BEND 0xE0
+
+struct ExprStream {
+  int16_t value;
+  byte source;        // ROUTE_SRC_ of the newest value
+  boolean pending;
+  uint32_t lastSent;  // micros()
+};
+
+uint32_t exprMinIntervalUs = EXPR_MIN_INTERVAL_US;
+
+static ExprStream exprBend[16];
+static ExprStream exprPressure[16];
+static ExprStream exprPoly[16];          // value unused, timing and pending for the channel
+static byte exprPolyValue[16][128];
+static uint32_t exprPolyPending[16][4];  // bit per note
+
+// Counters for checking the saving
+static uint32_t exprReceived = 0;
+static uint32_t exprSent = 0;
+static uint32_t exprNoteFlushes = 0;  // notes that had to flush a held value first
+static uint32_t exprOrderErrors = 0;  // notes sent with an earlier value still held, should stay 0
+
+inline boolean exprDue(const ExprStream &stream, uint32_t now) {
+  return stream.pending && now - stream.lastSent >= exprMinIntervalUs;
+}
+
+void exprSendBend(byte channel, uint32_t now) {
+  ExprStream &stream = exprBend[channel];
+  int bend = stream.value;
+  uint16_t raw = bend + 8192;
+  midiRouteSend(stream.source, ROUTE_EXPRESSION, MIDI_STATUS_PITCH_BEND | channel, raw & 0x7F, raw >> 7);
+  stream.pending = false;
+  stream.lastSent = now;
+  exprSent++;
+}
+
+void exprSendPressure(byte channel, uint32_t now) {
+  ExprStream &stream = exprPressure[channel];
+  midiRouteSend(stream.source, ROUTE_EXPRESSION, MIDI_STATUS_CHANNEL_PRESSURE | channel, stream.value, 0);
+  stream.pending = false;
+  stream.lastSent = now;
+  exprSent++;
+}
+
+void exprSendPoly(byte channel, uint32_t now) {
+  for (int word = 0; word < 4; word++) {
+    uint32_t bits = exprPolyPending[channel][word];
+    while (bits) {
+      int bit = __builtin_ctz(bits);
+      bits &= bits - 1;
+      byte note = word * 32 + bit;
+      byte pressure = exprPolyValue[channel][note];
+      midiRouteSend(exprPoly[channel].source, ROUTE_EXPRESSION, MIDI_STATUS_POLY_PRESSURE | channel, note, pressure);
+      exprSent++;
+    }
+    exprPolyPending[channel][word] = 0;
+  }
+  exprPoly[channel].pending = false;
+  exprPoly[channel].lastSent = now;
+}
+
+inline boolean exprPolyHeld(byte ch, byte note) {
+  return exprPolyPending[ch][note >> 5] & (1UL << (note & 31));
+}
+
+// True if anything that should go out before a note on channel ch is still held
+inline boolean exprHeldForNote(byte ch, byte note) {
+  return exprBend[ch].pending || exprPressure[ch].pending || exprPolyHeld(ch, note & 0x7F);
+}
+
+// Sends what a note on or off must not overtake, whatever the interval.
+// channel is 1-16 as given by the MIDI handlers.
+void exprFlushForNote(byte channel, byte note) {
+  byte ch = (channel - 1) & 0x0F;
+  note &= 0x7F;
+  if (!exprHeldForNote(ch, note)) return;
+  uint32_t now = micros();
+  exprNoteFlushes++;
+  if (exprBend[ch].pending) exprSendBend(ch, now);
+  if (exprPressure[ch].pending) exprSendPressure(ch, now);
+  if (exprPolyHeld(ch, note)) {
+    //Only this note, the rest of the channel keeps its interval
+    midiRouteSend(exprPoly[ch].source, ROUTE_EXPRESSION, MIDI_STATUS_POLY_PRESSURE | ch, note, exprPolyValue[ch][note]);
+    exprSent++;
+    exprPolyPending[ch][note >> 5] &= ~(1UL << (note & 31));
+    exprPoly[ch].pending = exprPolyPending[ch][0] || exprPolyPending[ch][1] || exprPolyPending[ch][2] || exprPolyPending[ch][3];
+  }
+  if (exprHeldForNote(ch, note)) exprOrderErrors++;
+}
+
+// Sends every stream whose interval has passed, call often
+void exprService() {
+  uint32_t now = micros();
+  for (byte channel = 0; channel < 16; channel++) {
+    if (exprDue(exprBend[channel], now)) exprSendBend(channel, now);
+    if (exprDue(exprPressure[channel], now)) exprSendPressure(channel, now);
+    if (exprDue(exprPoly[channel], now)) exprSendPoly(channel, now);
+  }
+}
+
+// channel is 1-16 as given by the MIDI handlers, source is the ROUTE_SRC_ port
+void exprQueueBend(byte source, byte channel, int bend) {
+  ExprStream &stream = exprBend[(channel - 1) & 0x0F];
+  stream.value = bend;
+  stream.source = source;
+  stream.pending = true;
+  exprReceived++;
+  if (exprDue(stream, micros())) exprSendBend((channel - 1) & 0x0F, micros());
+}
+
+void exprQueuePressure(byte source, byte channel, byte pressure) {
+  ExprStream &stream = exprPressure[(channel - 1) & 0x0F];
+  stream.value = pressure;
+  stream.source = source;
+  stream.pending = true;
+  exprReceived++;
+  if (exprDue(stream, micros())) exprSendPressure((channel - 1) & 0x0F, micros());
+}
+
+void exprQueuePolyPressure(byte source, byte channel, byte note, byte pressure) {
+  byte ch = (channel - 1) & 0x0F;
+  note &= 0x7F;
+  exprPoly[ch].source = source;
+  exprPolyValue[ch][note] = pressure;
+  exprPolyPending[ch][note >> 5] |= 1UL << (note & 31);
+  exprPoly[ch].pending = true;
+  exprReceived++;
+  if (exprDue(exprPoly[ch], micros())) exprSendPoly(ch, micros());
+}
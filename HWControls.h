@@ -289,20 +289,9 @@ ADC *adc = new ADC();
 #define ENCODER_PINB 5
 
 #define MUXCHANNELS 16
-#define QUANTISE_FACTOR 31
 
 #define DEBOUNCE 30
 
-static byte muxInput = 0;
-
-static int mux1ValuesPrev[MUXCHANNELS] = {};
-static int mux2ValuesPrev[MUXCHANNELS] = {};
-static int mux3ValuesPrev[MUXCHANNELS] = {};
-
-static int mux1Read = 0;
-static int mux2Read = 0;
-static int mux3Read = 0;
-
 static long encPrevious = 0;
 
 //These are pushbuttons and require debouncing
@@ -315,17 +304,16 @@ TButton recallButton{ RECALL_SW, LOW, HOLD_DURATION, DEBOUNCE, CLICK_DURATION };
 Encoder encoder(ENCODER_PINB, ENCODER_PINA);  //This often needs the pins swapping depending on the encoder
 
 void setupHardware() {
-  //Volume Pot is on ADC0
-  adc->adc0->setAveraging(32);                                          // set number of averages 0, 4, 8, 16 or 32.
-  adc->adc0->setResolution(12);                                         // set bits of resolution  8, 10, 12 or 16 bits.
-  adc->adc0->setConversionSpeed(ADC_CONVERSION_SPEED::VERY_LOW_SPEED);  // change the conversion speed
-  adc->adc0->setSamplingSpeed(ADC_SAMPLING_SPEED::MED_SPEED);           // change the sampling speed
-
-  //MUXs on ADC1
-  adc->adc1->setAveraging(32);                                          // set number of averages 0, 4, 8, 16 or 32.
-  adc->adc1->setResolution(12);                                         // set bits of resolution  8, 10, 12 or 16 bits.
-  adc->adc1->setConversionSpeed(ADC_CONVERSION_SPEED::VERY_LOW_SPEED);  // change the conversion speed
-  adc->adc1->setSamplingSpeed(ADC_SAMPLING_SPEED::MED_SPEED);           // change the sampling speed
+  //MUXs are shared between ADC0 and ADC1 by the background scan, each conversion must fit in one scan step
+  adc->adc0->setAveraging(4);                                       // set number of averages 0, 4, 8, 16 or 32.
+  adc->adc0->setResolution(12);                                     // set bits of resolution  8, 10, 12 or 16 bits.
+  adc->adc0->setConversionSpeed(ADC_CONVERSION_SPEED::HIGH_SPEED);  // change the conversion speed
+  adc->adc0->setSamplingSpeed(ADC_SAMPLING_SPEED::MED_SPEED);       // change the sampling speed
+
+  adc->adc1->setAveraging(4);                                       // set number of averages 0, 4, 8, 16 or 32.
+  adc->adc1->setResolution(12);                                     // set bits of resolution  8, 10, 12 or 16 bits.
+  adc->adc1->setConversionSpeed(ADC_CONVERSION_SPEED::HIGH_SPEED);  // change the conversion speed
+  adc->adc1->setSamplingSpeed(ADC_SAMPLING_SPEED::MED_SPEED);       // change the sampling speed
 
   //Mux address pins
 
@@ -0,0 +1,131 @@
+// High resolution parameter output
+//
+// With CC Type set to High Res, parameters marked in ccResolution[] are sent with
+// 14 bits instead of 7. The pots supply their full 12 bit reading, everything else
+// (recall, incoming MIDI) is scaled up from 7 bits.
+//   CC_RES_14BIT - MSB on cc, LSB on cc + 32, only valid for cc 0-31
+//   CC_RES_NRPN  - NRPN with the parameter number equal to cc
+// Each part of a message is only sent when it has changed since the last send on that port.
+// setupHiResCC() only enables a mode whose extra controller numbers no parameter uses,
+// everything else stays 7 bit. With the current CC map that is only Emphasis (28/60):
+// the NRPN numbers and the LSB partners of cutoff and the tuning pots are all taken by
+// other parameters, so the setting is shown as "Some High Res".
+
+#define CC_RES_7BIT 0
+#define CC_RES_14BIT 1
+#define CC_RES_NRPN 2
+
+#define CC_TYPE_CC 0
+#define CC_TYPE_HIRES 1
+#define CC_TYPE_SYSEX 2
+
+#define NRPN_MSB 99
+#define NRPN_LSB 98
+#define DATA_ENTRY_MSB 6
+#define DATA_ENTRY_LSB 38
+#define CC_LSB_OFFSET 32
+
+#define NO_HIRES_VALUE -1
+#define NO_NRPN_SELECTED 0xFFFF
+
+// Everything is 7 bit until setupHiResCC() has checked the map
+byte ccResolution[128] = {};
+
+// Parameters on buttons that sit on numbers an LSB or NRPN message would use,
+// the pots are checked against potMap
+const byte hiResButtonCCs[] = {
+  CCkeyboardControlSW, CCphaserSW, CClfoDestPW3, CClfoDestFilter, CCechoSyncSW, CClfoDestOsc1, CClfoSaw, CClfoTriangle
+};
+
+static int hiResPending = NO_HIRES_VALUE;  // full resolution pot reading for the CC in progress
+
+// What the receiver on one port has last been sent
+struct HiResPort {
+  uint16_t lastSent[128];  // last 14 bit value sent per cc
+  boolean sent[128];       // has anything been sent yet
+  uint16_t nrpnSelected;   // parameter currently selected on the receiver
+};
+
+HiResPort hiResUSB = { {}, {}, NO_NRPN_SELECTED };
+HiResPort hiResDIN = { {}, {}, NO_NRPN_SELECTED };
+HiResPort hiResHost = { {}, {}, NO_NRPN_SELECTED };
+
+typedef void (*CCSender)(byte cc, byte value);
+
+boolean hiResNumberFree(byte number) {
+  for (int mux = 0; mux < MUX_COUNT; mux++) {
+    for (int i = 0; i < MUXCHANNELS; i++) {
+      if (potMap[mux][i].cc == number) return false;
+    }
+  }
+  for (unsigned int i = 0; i < sizeof(hiResButtonCCs); i++) {
+    if (hiResButtonCCs[i] == number) return false;
+  }
+  return true;
+}
+
+// Picks the resolution for each pot from potMap, call again after changing the map.
+// MSB/LSB needs cc + 32 free, NRPN needs all four of its controller numbers free.
+void setupHiResCC() {
+  boolean nrpnFree = hiResNumberFree(NRPN_MSB) && hiResNumberFree(NRPN_LSB)
+                     && hiResNumberFree(DATA_ENTRY_MSB) && hiResNumberFree(DATA_ENTRY_LSB);
+  int enabled = 0;
+
+  memset(ccResolution, CC_RES_7BIT, sizeof(ccResolution));
+  for (int mux = 0; mux < MUX_COUNT; mux++) {
+    for (int i = 0; i < MUXCHANNELS; i++) {
+      byte cc = potMap[mux][i].cc;
+      if (cc == POT_UNASSIGNED || cc >= 128) continue;
+      if (cc < CC_LSB_OFFSET && hiResNumberFree(cc + CC_LSB_OFFSET)) {
+        ccResolution[cc] = CC_RES_14BIT;
+      } else if (nrpnFree) {
+        ccResolution[cc] = CC_RES_NRPN;
+      } else {
+        continue;
+      }
+      enabled++;
+    }
+  }
+  Serial.println("High res CCs:" + String(enabled) + (nrpnFree ? "" : " (NRPN numbers in use)"));
+}
+
+inline boolean ccIsHiRes(byte cc) {
+  return ccType == CC_TYPE_HIRES && cc < 128 && ccResolution[cc] != CC_RES_7BIT;
+}
+
+// 14 bit value to send for cc, the pot reading if it belongs to this value, otherwise value scaled up
+uint16_t hiResValue(byte value) {
+  if (hiResPending != NO_HIRES_VALUE && (hiResPending >> 7) == value) return hiResPending;
+  return (value << 7) | value;
+}
+
+void hiResEncode(HiResPort &port, byte cc, uint16_t value, CCSender send) {
+  byte msb = value >> 7;
+  byte lsb = value & 0x7F;
+  boolean sent = port.sent[cc];
+  uint16_t last = port.lastSent[cc];
+
+  if (ccResolution[cc] == CC_RES_14BIT && cc < CC_LSB_OFFSET) {
+    if (!sent || msb != (last >> 7)) send(cc, msb);
+    if (!sent || lsb != (last & 0x7F)) send(cc + CC_LSB_OFFSET, lsb);
+  } else {
+    if (port.nrpnSelected != cc) {
+      send(NRPN_MSB, 0);
+      send(NRPN_LSB, cc);
+      port.nrpnSelected = cc;
+      sent = false;  //Receiver may have applied the old data to another parameter
+    }
+    if (!sent || msb != (last >> 7)) send(DATA_ENTRY_MSB, msb);
+    if (!sent || lsb != (last & 0x7F)) send(DATA_ENTRY_LSB, lsb);
+  }
+  port.lastSent[cc] = value;
+  port.sent[cc] = true;
+}
+
+void usbSendCC(byte cc, byte value) {
+  usbOutControlChange(cc, value, midiOutCh);
+}
+
+void hostSendCC(byte cc, byte value) {
+  midi1.sendControlChange(cc, value, midiOutCh);
+}
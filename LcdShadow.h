@@ -0,0 +1,100 @@
+// Shadow buffer for the 2 x 20 character LCD
+//
+// Everything that writes to the LCD only changes lcdWanted, which costs a few byte
+// copies. lcdService() is called from loop() and compares it with lcdShown, what the
+// LCD is known to hold, and sends the first run of changed cells it finds. Each call
+// sends at most LCD_FLUSH_CELLS characters in a single Wire transmission straight to the
+// PCF8574 backpack, so a screen change is spread over a few passes of loop() instead of
+// stalling the pot path. Teensy 4 Wire has no background transfer, the run length keeps
+// each call short instead.
+
+#define LCD_LINES 2
+#define LCD_COLS 20
+#define LCD_LINE_ONE 0
+#define LCD_LINE_TWO 1
+#define LCD_I2C_ADDRESS 0x27
+#define LCD_FLUSH_CELLS 7  // address command + 7 characters fills the 32 byte Wire buffer
+
+// PCF8574 to HD44780 wiring on the backpack
+#define LCD_RS 0x01
+#define LCD_EN 0x04
+#define LCD_BACKLIGHT 0x08
+#define LCD_SET_DDRAM 0x80
+#define LCD_LINE_TWO_DDRAM 0x40
+
+static char lcdWanted[LCD_LINES][LCD_COLS];
+static char lcdShown[LCD_LINES][LCD_COLS];
+static volatile boolean lcdDirty = false;
+
+// Counters for checking the saving
+static uint32_t lcdCellsWritten = 0;
+static uint32_t lcdTransmissions = 0;
+
+// Call once the LCD has been cleared by the library
+void setupLcdShadow() {
+  memset(lcdWanted, ' ', sizeof(lcdWanted));
+  memset(lcdShown, ' ', sizeof(lcdShown));
+  lcdDirty = false;
+}
+
+void lcdPrint(byte line, byte col, const char *text) {
+  if (line >= LCD_LINES) return;
+  while (*text && col < LCD_COLS) {
+    lcdWanted[line][col++] = *text++;
+  }
+  lcdDirty = true;
+}
+
+void lcdClearLine(byte line) {
+  if (line >= LCD_LINES) return;
+  memset(lcdWanted[line], ' ', LCD_COLS);
+  lcdDirty = true;
+}
+
+void lcdClearScreen() {
+  memset(lcdWanted, ' ', sizeof(lcdWanted));
+  lcdDirty = true;
+}
+
+// One byte to the HD44780 as two 4 bit writes, each latched by a pulse on EN
+inline void lcdWireByte(byte value, byte mode) {
+  byte high = (value & 0xF0) | mode | LCD_BACKLIGHT;
+  byte low = (value << 4) | mode | LCD_BACKLIGHT;
+  Wire.write(high | LCD_EN);
+  Wire.write(high);
+  Wire.write(low | LCD_EN);
+  Wire.write(low);
+}
+
+// Sends the next run of changed cells, call once per loop
+void lcdService() {
+  if (!lcdDirty) return;
+  lcdDirty = false;  //Set again below, or by a write made while this scan runs
+  for (byte line = 0; line < LCD_LINES; line++) {
+    byte col = 0;
+    while (col < LCD_COLS && lcdWanted[line][col] == lcdShown[line][col]) col++;
+    if (col == LCD_COLS) continue;
+
+    //Unchanged cells inside a run are cheaper to resend than another address command
+    byte end = min(col + LCD_FLUSH_CELLS, LCD_COLS);
+    while (end > col && lcdWanted[line][end - 1] == lcdShown[line][end - 1]) end--;
+
+    Wire.beginTransmission(LCD_I2C_ADDRESS);
+    lcdWireByte(LCD_SET_DDRAM | (line ? LCD_LINE_TWO_DDRAM : 0) | col, 0);
+    for (byte i = col; i < end; i++) {
+      char c = lcdWanted[line][i];
+      lcdWireByte(c, LCD_RS);
+      lcdShown[line][i] = c;
+    }
+    Wire.endTransmission();
+    lcdCellsWritten += end - col;
+    lcdTransmissions++;
+    lcdDirty = true;
+    return;
+  }
+}
+
+// Sends everything outstanding, only for start up before loop() runs
+void lcdFlush() {
+  while (lcdDirty) lcdService();
+}
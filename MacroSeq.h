@@ -0,0 +1,196 @@
+// Timed keystroke macros for the VST menus on MIDI6
+//
+// Settings such as arp mode or number of voices are chosen in the VST by opening a menu
+// and stepping down it with arrow keys, each key needs time to be taken. The steps are
+// queued here and sent by macroService() from loop(), so a patch recall no longer stops
+// the panel, display and MIDI thru while the keys go out.
+//
+// Every macro has a kind, queueing a new macro of a kind replaces one still waiting.
+// A macro that has already opened its menu is closed with Enter rather than left open.
+// The done callback is called with true once the last key is sent, false if cancelled.
+// The panel buttons that step a menu by hand queue their keys here too, so they never
+// land inside a menu a macro has open.
+//
+// Each menu is modelled with its open key, the value of its top entry and the selection
+// the VST was last left on. Like the panel buttons, the macros take a menu to open with
+// nothing highlighted so the first Down lands on the top entry, and step down from there.
+// A macro that would choose what the VST already has is not queued at all.
+
+#define MACRO_STEPS 96
+#define MACRO_KEY_GAP_MS 500  // between keys within a menu
+#define MACRO_LEAD_MS 200     // between one menu closing and the next opening
+
+#define MACRO_ARP_MODE 0
+#define MACRO_ARP_RANGE 1
+#define MACRO_VOICES 2
+#define MACRO_MONO 3
+#define MACRO_POLY 4
+#define MACRO_REVERB_TYPE 5
+#define MACRO_KINDS 6
+#define MACRO_CLOSE MACRO_KINDS  // Enter closing a cancelled menu, never cancelled itself
+
+#define MENU_UNKNOWN 0xFF
+
+struct VstMenu {
+  byte openCC;  // key that opens the menu
+  byte first;   // value of the top entry
+};
+
+const VstMenu vstMenus[MACRO_KINDS] = {
+  { MIDIarpModeSW, 1 },     // MACRO_ARP_MODE
+  { MIDIarpRangeSW, 1 },    // MACRO_ARP_RANGE
+  { MIDImaxVoicesSW, 2 },   // MACRO_VOICES
+  { MIDImonoSW, 1 },        // MACRO_MONO
+  { MIDIpolySW, 1 },        // MACRO_POLY
+  { MIDIreverbTypeSW, 1 }   // MACRO_REVERB_TYPE
+};
+
+typedef void (*MacroDone)(boolean completed);
+
+struct MacroStep {
+  byte cc;
+  uint16_t gapMs;  // wait after the previous key before sending this one
+  byte kind;
+  byte at;         // menu entry highlighted once this key is taken
+  boolean last;
+};
+
+static MacroStep macroSteps[MACRO_STEPS];
+static uint8_t macroHead = 0;
+static uint8_t macroCount = 0;
+static unsigned long macroLastKey = 0;
+static boolean macroStarted[MACRO_KINDS] = {};  // menu is open in the VST
+static MacroDone macroDone[MACRO_KINDS] = {};
+static byte menuSelection[MACRO_KINDS] = { MENU_UNKNOWN, MENU_UNKNOWN, MENU_UNKNOWN, MENU_UNKNOWN, MENU_UNKNOWN, MENU_UNKNOWN };
+static byte menuCursor[MACRO_KINDS] = {};  // highlighted entry while a menu is open
+static uint32_t macroKeysSent = 0;
+
+inline MacroStep &macroAt(uint8_t i) {
+  return macroSteps[(macroHead + i) % MACRO_STEPS];
+}
+
+boolean macroPush(byte kind, byte cc, uint16_t gapMs, byte at, boolean last) {
+  if (macroCount >= MACRO_STEPS) return false;
+  macroAt(macroCount) = { cc, gapMs, kind, at, last };
+  macroCount++;
+  return true;
+}
+
+// Drops the waiting keys of a kind, closing its menu if it is already open
+void macroCancel(byte kind) {
+  uint8_t kept = 0;
+  boolean found = false;
+  for (uint8_t i = 0; i < macroCount; i++) {
+    MacroStep step = macroAt(i);
+    if (step.kind == kind) {
+      found = true;
+    } else {
+      macroAt(kept++) = step;
+    }
+  }
+  macroCount = kept;
+
+  if (macroStarted[kind]) {
+    //Its keys are at the front of the queue, Enter goes there too
+    if (macroCount < MACRO_STEPS) {
+      macroHead = (macroHead + MACRO_STEPS - 1) % MACRO_STEPS;
+      macroSteps[macroHead] = { MIDIEnter, MACRO_KEY_GAP_MS, MACRO_CLOSE, menuCursor[kind], true };
+      macroCount++;
+      menuSelection[kind] = menuCursor[kind];
+    } else {
+      menuSelection[kind] = MENU_UNKNOWN;
+    }
+    found = true;
+  }
+  macroStarted[kind] = false;
+
+  if (found && macroDone[kind]) {
+    MacroDone done = macroDone[kind];
+    macroDone[kind] = NULL;
+    done(false);
+  }
+}
+
+// Drops everything waiting, on patch recall the new patch replaces what was queued
+void macroCancelAll() {
+  for (byte kind = 0; kind < MACRO_KINDS; kind++) {
+    macroCancel(kind);
+  }
+}
+
+// Panel button opening a menu by hand, drops a macro still waiting for that menu
+void macroPanelOpen(byte kind) {
+  macroCancel(kind);
+  if (!macroPush(kind, vstMenus[kind].openCC, MACRO_LEAD_MS, vstMenus[kind].first - 1, false)) {
+    menuSelection[kind] = MENU_UNKNOWN;  //Queue full, the key is lost
+  }
+}
+
+// Panel button key in a menu opened by hand, at is the entry highlighted once it is taken.
+// Enter selects at, Escape leaves the selection unknown.
+void macroPanelKey(byte kind, byte cc, byte at) {
+  boolean last = (cc == MIDIEnter || cc == MIDIEscape);
+  if (cc == MIDIEscape) at = MENU_UNKNOWN;
+  if (!macroPush(kind, cc, 0, at, last)) {
+    menuSelection[kind] = MENU_UNKNOWN;  //Queue full, the key is lost
+  }
+}
+
+// Opens a VST menu, steps down from the top to value and selects it.
+// done(false) is called before returning if the queue is full.
+void macroMenuSelect(byte kind, byte value, MacroDone done) {
+  const VstMenu &menu = vstMenus[kind];
+  macroDone[kind] = NULL;  //Replaced, not cancelled, the caller is about to queue the new value
+  macroCancel(kind);
+  byte from = menuSelection[kind];
+
+  if (from == value) {
+    if (done) done(true);
+    return;
+  }
+
+  macroDone[kind] = done;
+  uint16_t gap = 0;
+  macroPush(kind, menu.openCC, MACRO_LEAD_MS, menu.first - 1, false);
+  for (byte at = menu.first; at <= value; at++) {
+    macroPush(kind, MIDIDownArrow, gap, at, false);
+    gap = MACRO_KEY_GAP_MS;
+  }
+  if (!macroPush(kind, MIDIEnter, MACRO_KEY_GAP_MS, value, true)) {
+    macroCancel(kind);  //Queue full, don't leave half a macro behind
+  }
+}
+
+inline boolean macroBusy() {
+  return macroCount > 0;
+}
+
+// Sends the next key once its gap has passed, call once per loop
+void macroService() {
+  if (macroCount == 0) return;
+  MacroStep &step = macroSteps[macroHead];
+  if (millis() - macroLastKey < step.gapMs) return;
+
+  MIDI6.sendControlChange(step.cc, 127, midiOutCh);
+  macroLastKey = millis();
+  macroKeysSent++;
+  byte kind = step.kind;
+  byte at = step.at;
+  boolean last = step.last;
+  macroHead = (macroHead + 1) % MACRO_STEPS;
+  macroCount--;
+
+  if (kind == MACRO_CLOSE) return;
+  menuCursor[kind] = at;
+  if (last) {
+    menuSelection[kind] = at;
+    macroStarted[kind] = false;
+    if (macroDone[kind]) {
+      MacroDone done = macroDone[kind];
+      macroDone[kind] = NULL;
+      done(true);
+    }
+  } else {
+    macroStarted[kind] = true;
+  }
+}
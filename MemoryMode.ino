@@ -35,6 +35,9 @@
 #include "Parameters.h"
 #include "PatchMgr.h"
 #include "HWControls.h"
+#include "MuxScan.h"
+#include "PotFilter.h"
+#include "PotMap.h"
 #include "EepromMgr.h"
 #include <RoxMux.h>
 
@@ -61,8 +64,11 @@ USBHub hub1(myusb);
 USBHub hub2(myusb);
 MIDIDevice midi1(myusb);
 
-//MIDI 5 Pin DIN
-MIDI_CREATE_INSTANCE(HardwareSerial, Serial1, MIDI);
+//MIDI 5 Pin DIN, running status saves a byte on every CC in a run
+struct DinMidiSettings : public midi::DefaultSettings {
+  static const bool UseRunningStatus = true;
+};
+MIDI_CREATE_CUSTOM_INSTANCE(HardwareSerial, Serial1, MIDI, DinMidiSettings);
 MIDI_CREATE_INSTANCE(HardwareSerial, Serial6, MIDI6);
 
 #define OCTO_TOTAL 10
@@ -85,10 +91,27 @@ Rox74HC595<SR_TOTAL> sr;
 
 byte ccType = 0;  //(EEPROM)
 
+#include "UsbMidiOut.h"
+#include "HiResCC.h"
+#include "MidiOut.h"
+#include "MidiRouter.h"
+#include "ParamSync.h"
+#include "MacroSeq.h"
+#include "MidiIn.h"
+#include "ExpressionOut.h"
 #include "Settings.h"
 
 int count = 0;  //For MIDI Clk Sync
 int DelayForSH3 = 12;
+
+unsigned long recallStartMicros = 0;
+unsigned long recallParamsMicros = 0;  //Recall to last parameter message
+unsigned long recallMenusMillis = 0;   //Recall to last VST menu key
+boolean recallTiming = false;
+
+boolean vstInSync = false;  //VST has had a full recall and follows the panel since
+boolean recallDiff = false;
+int recallChanged = 0;      //Parameters applied by the last recall
 int patchNo = 1;               //Current patch no
 int voiceToReturn = -1;        //Initialise
 long earliestTime = millis();  //For voice allocation - initialise to now
@@ -108,6 +131,10 @@ void setup() {
   setupDisplay();
   setUpSettings();
   setupHardware();
+  setupPotFilter();
+  potMapReset();
+  setupMuxScan();
+  setupMidiOut();
 
   cardStatus = SD.begin(BUILTIN_SDCARD);
   if (cardStatus) {
@@ -131,12 +158,14 @@ void setup() {
 
   //Read CC type from EEPROM
   ccType = getCCType();
+  setupHiResCC();
 
   //Read UpdateParams type from EEPROM
   updateParams = getUpdateParams();
 
   //Read SendNotes type from EEPROM
   sendNotes = getSendNotes();
+  setupMidiRoutes();
 
   //USB HOST MIDI Class Compliant
   delay(400);  //Wait to turn on USB Host
@@ -147,6 +176,7 @@ void setup() {
   midi1.setHandleNoteOn(myNoteOn);
   midi1.setHandlePitchChange(myPitchBend);
   midi1.setHandleAfterTouch(myAfterTouch);
+  midi1.setHandleAfterTouchPoly(myPolyAfterTouch);
   Serial.println("USB HOST MIDI Class Compliant Listening");
 
   //USB Client MIDI
@@ -156,6 +186,7 @@ void setup() {
   usbMIDI.setHandleNoteOn(myNoteOn);
   usbMIDI.setHandlePitchChange(myPitchBend);
   usbMIDI.setHandleAfterTouch(myAfterTouch);
+  usbMIDI.setHandleAfterTouchPoly(myPolyAfterTouch);
   Serial.println("USB Client MIDI Listening");
 
   //MIDI 5 Pin DIN
@@ -166,6 +197,7 @@ void setup() {
   MIDI.setHandleNoteOff(myNoteOff);
   MIDI.setHandlePitchBend(myPitchBend);
   MIDI.setHandleAfterTouchChannel(myAfterTouch);
+  MIDI.setHandleAfterTouchPoly(myPolyAfterTouch);
   Serial.println("MIDI In DIN Listening");
 
   MIDI6.begin();
@@ -176,20 +208,26 @@ void setup() {
   //Read MIDI Out Channel from EEPROM
   midiOutCh = getMIDIOutCh();
 
-  LCD.PCF8574_LCDClearScreen();
+  lcdClearScreen();
   recallPatch(patchNo);  //Load first patch
 }
 
 void myNoteOn(byte channel, byte note, byte velocity) {
+  midiInQueue(MIDI_IN_NOTE_ON, channel, note, velocity);
+}
+
+void myNoteOff(byte channel, byte note, byte velocity) {
+  midiInQueue(MIDI_IN_NOTE_OFF, channel, note, velocity);
+}
+
+void forwardNoteOn(byte source, byte channel, byte note, byte velocity) {
   if (learning) {
     learningNote = note;
     noteArrived = true;
   }
   if (!learning) {
-    MIDI.sendNoteOn(note, velocity, channel);
-    if (sendNotes) {
-      usbMIDI.sendNoteOn(note, velocity, channel);
-    }
+    exprFlushForNote(channel, note);  //Bend and pressure that came in first go out first
+    midiRouteSend(source, ROUTE_NOTES, MIDI_STATUS_NOTE_ON | (channel - 1), note, velocity);
   }
 
   if (chordMemoryWait) {
@@ -199,12 +237,10 @@ void myNoteOn(byte channel, byte note, byte velocity) {
   }
 }
 
-void myNoteOff(byte channel, byte note, byte velocity) {
+void forwardNoteOff(byte source, byte channel, byte note, byte velocity) {
   if (!learning) {
-    MIDI.sendNoteOff(note, velocity, channel);
-    if (sendNotes) {
-      usbMIDI.sendNoteOff(note, velocity, channel);
-    }
+    exprFlushForNote(channel, note);
+    midiRouteSend(source, ROUTE_NOTES, MIDI_STATUS_NOTE_OFF | (channel - 1), note, velocity);
   }
 }
 
@@ -216,85 +252,128 @@ void convertIncomingNote() {
 }
 
 void myConvertControlChange(byte channel, byte number, byte value) {
+  if (!midiInWanted(channel)) return;
+  if (echoIsOwn(number, value)) {
+    echoSuppressed++;
+    return;
+  }
+  remoteChanges++;
   int newvalue = value;
+  paramOrigin = ORIGIN_REMOTE;
+  paramOriginSource = midiInSource;
   myControlChange(channel, number, newvalue);
+  paramOrigin = ORIGIN_LOCAL;
 }
 
 void myPitchBend(byte channel, int bend) {
-  MIDI.sendPitchBend(bend, channel);
-  if (sendNotes) {
-    usbMIDI.sendPitchBend(bend, channel);
-  }
+  midiInQueue(MIDI_IN_PITCH_BEND, channel, 0, bend);
 }
 
 void myAfterTouch(byte channel, byte pressure) {
-  MIDI.sendAfterTouch(pressure, channel);
-  if (sendNotes) {
-    usbMIDI.sendAfterTouch(pressure, channel);
+  midiInQueue(MIDI_IN_AFTERTOUCH, channel, 0, pressure);
+}
+
+void myPolyAfterTouch(byte channel, byte note, byte pressure) {
+  midiInQueue(MIDI_IN_POLY_AFTERTOUCH, channel, note, pressure);
+}
+
+// Sends on everything waiting in the input ring
+void forwardMidiIn() {
+  while (midiInPending()) {
+    MidiInEvent event = midiInTake();
+    switch (event.type) {
+      case MIDI_IN_NOTE_ON:
+        forwardNoteOn(event.source, event.channel, event.data1, event.value);
+        break;
+      case MIDI_IN_NOTE_OFF:
+        forwardNoteOff(event.source, event.channel, event.data1, event.value);
+        break;
+      case MIDI_IN_PITCH_BEND:
+        exprQueueBend(event.source, event.channel, event.value);
+        break;
+      case MIDI_IN_AFTERTOUCH:
+        exprQueuePressure(event.source, event.channel, event.value);
+        break;
+      case MIDI_IN_POLY_AFTERTOUCH:
+        exprQueuePolyPressure(event.source, event.channel, event.data1, event.value);
+        break;
+    }
+    midiInForwarded(event);
   }
 }
 
-void updateMOOGstyle(int PREVparam, int value, String WhichParameter) {
+// Reads every MIDI port until it is empty, then forwards what came in
+void pollMidiIn() {
+  midiInBeginPoll();
+  myusb.Task();
+  midiInSource = ROUTE_SRC_HOST;
+  while (midi1.read()) {}  //USB HOST MIDI Class Compliant
+  midiInSource = ROUTE_SRC_DIN;
+  while (MIDI.read(midiChannel) || Serial1.available() > 0) {}
+  midiInSource = ROUTE_SRC_USB;
+  while (usbMIDI.read()) {}  //Omni, read(channel) stops at the first message on another channel
+  midiInSource = ROUTE_SRC_LOCAL;
+  forwardMidiIn();
+  exprService();
+}
+
+void updateMOOGstyle(int PREVparam, int value, const char *WhichParameter) {
   LCD_timer = millis();
-  if (WhichParameter.equals(oldWhichParameter)) {
-    char spaces2[] = "   ";
-    LCD.PCF8574_LCDGOTO(LCD.LCDLineNumberOne, 11);
-    LCD.PCF8574_LCDSendString(spaces2);
+  lcdParam.prev = PREVparam;
+  lcdParam.value = value;
+  lcdParam.name = WhichParameter;
+  lcdParam.pending = true;
+}
+
+// Shows the newest parameter change, at most once per UI_FRAME_MS however many arrive
+void serviceUI() {
+  if (state != displayDraft.state) {
+    displayChanged();  //Pages and patch lists follow state changes
+    uiStateMillis = millis();
+  }
+  if (state == REINITIALISE && millis() - uiStateMillis > REINITIALISE_SHOW_MS) state = PARAMETER;  //Message has been up long enough
+  if (!lcdParam.pending && !paramPage.pending) return;
+  if (millis() - uiLastFrame < UI_FRAME_MS) return;
+  uiLastFrame = millis();
+  if (lcdParam.pending) renderMOOGstyle();
+  if (paramPage.pending) publishParamPage();
+}
+
+void renderMOOGstyle() {
+  lcdParam.pending = false;
+  int PREVparam = lcdParam.prev;
+  int value = lcdParam.value;
+  const char *WhichParameter = lcdParam.name;
+  if (strcmp(WhichParameter, oldWhichParameter) == 0) {
+    lcdPrint(LCD_LINE_ONE, 11, "   ");
   } else {
-    char spaces1[] = "                    ";
-    LCD.PCF8574_LCDGOTO(LCD.LCDLineNumberOne, 0);
-    LCD.PCF8574_LCDSendString(spaces1);
-    LCD.PCF8574_LCDGOTO(LCD.LCDLineNumberTwo, 0);
-    LCD.PCF8574_LCDSendString(spaces1);
+    lcdClearScreen();
     oldWhichParameter = WhichParameter;
   }
 
-  String myString = String(PREVparam, DEC);
-  if (PREVparam < 10) {
-    myString = "00" + myString;
-  }
-  if (PREVparam < 100 && PREVparam > 9) {
-    myString = "0" + myString;
-  }
   char myChar[4];
-  myString.toCharArray(myChar, sizeof(myChar));
-  LCD.PCF8574_LCDGOTO(LCD.LCDLineNumberOne, 6);
-  LCD.PCF8574_LCDSendString(myChar);
+  snprintf(myChar, sizeof(myChar), "%03d", PREVparam);
+  lcdPrint(LCD_LINE_ONE, 6, myChar);
 
-  String myString2 = String(value, DEC);
-  if (value < 10) {
-    myString2 = "00" + myString2;
-  }
-  if (value < 100 && value > 9) {
-    myString2 = "0" + myString2;
-  }
   char myChar2[4];
-  myString2.toCharArray(myChar2, sizeof(myChar2));
-  LCD.PCF8574_LCDGOTO(LCD.LCDLineNumberOne, 11);
-  LCD.PCF8574_LCDSendString(myChar2);
+  snprintf(myChar2, sizeof(myChar2), "%03d", value);
+  lcdPrint(LCD_LINE_ONE, 11, myChar2);
 
-  char destinationArray[WhichParameter.length() + 1];
-  WhichParameter.toCharArray(destinationArray, sizeof(destinationArray));
-  LCD.PCF8574_LCDGOTO(LCD.LCDLineNumberTwo, 0);
-  LCD.PCF8574_LCDSendString(destinationArray);
+  lcdPrint(LCD_LINE_TWO, 0, WhichParameter);
 }
 
 void allNotesOff() {
 }
 
+void arpModePresetDone(boolean completed) {
+  if (!completed) arpModePREV = 100;  //VST left unknown, send it next time
+}
+
 void updatearpModePreset() {
 
   if (arpMode != arpModePREV) {
-
-    midi6CCOut(MIDIarpModeSW, 127);
-    midi6CCOut(MIDIDownArrow, 127);
-    for (int i = 1; i < arpMode; i++) {
-      delay(500);
-      midi6CCOut(MIDIDownArrow, 127);
-    }
-    delay(500);
-    midi6CCOut(MIDIEnter, 127);
     arpModePREV = arpMode;
+    macroMenuSelect(MACRO_ARP_MODE, arpMode, arpModePresetDone);
   }
 }
 
@@ -327,8 +406,8 @@ void updatearpMode() {
     if (!recallPatchFlag) {
       arpModeNames();
     }
-    midi6CCOut(MIDIarpModeSW, 127);
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelOpen(MACRO_ARP_MODE);
+    macroPanelKey(MACRO_ARP_MODE, MIDIDownArrow, arpMode);
     arpModeFirstPress++;
   } else if (arpModeSW == 1 && arpModeFirstPress > 0) {
     arpMode++;
@@ -338,7 +417,7 @@ void updatearpMode() {
     if (!recallPatchFlag) {
       arpModeNames();
     }
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelKey(MACRO_ARP_MODE, MIDIDownArrow, arpMode);
     arpModeFirstPress++;
     arpMode_timer = millis();
   }
@@ -349,7 +428,7 @@ void updatearpModeExitSW() {
     if (!recallPatchFlag) {
       arpModeNames();
     }
-    midi6CCOut(MIDIEnter, 127);
+    macroPanelKey(MACRO_ARP_MODE, MIDIEnter, arpMode);
     arpModeFirstPress = 0;
     arpModeSW = 0;
     arpModeExitSW = 0;
@@ -358,19 +437,15 @@ void updatearpModeExitSW() {
   }
 }
 
+void arpRangePresetDone(boolean completed) {
+  if (!completed) arpRangePREV = 100;  //VST left unknown, send it next time
+}
+
 void updatearpRangePreset() {
 
   if (arpRange != arpRangePREV) {
-
-    midi6CCOut(MIDIarpRangeSW, 127);
-    midi6CCOut(MIDIDownArrow, 127);
-    for (int i = 1; i < arpRange; i++) {
-      delay(500);
-      midi6CCOut(MIDIDownArrow, 127);
-    }
-    delay(500);
-    midi6CCOut(MIDIEnter, 127);
     arpRangePREV = arpRange;
+    macroMenuSelect(MACRO_ARP_RANGE, arpRange, arpRangePresetDone);
   }
 }
 
@@ -382,8 +457,8 @@ void updatearpRange() {
     if (!recallPatchFlag) {
       arpRangeDisplay();
     }
-    midi6CCOut(MIDIarpRangeSW, 127);
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelOpen(MACRO_ARP_RANGE);
+    macroPanelKey(MACRO_ARP_RANGE, MIDIDownArrow, arpRange);
     arpRangeFirstPress++;
   } else if (arpRangeSW == 1 && arpRangeFirstPress > 0) {
     arpRange++;
@@ -393,7 +468,7 @@ void updatearpRange() {
     if (!recallPatchFlag) {
       arpRangeDisplay();
     }
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelKey(MACRO_ARP_RANGE, MIDIDownArrow, arpRange);
     arpRangeFirstPress++;
     arpRange_timer = millis();
   }
@@ -404,7 +479,7 @@ void updatearpRangeExitSW() {
     if (!recallPatchFlag) {
       arpRangeDisplay();
     }
-    midi6CCOut(MIDIEnter, 127);
+    macroPanelKey(MACRO_ARP_RANGE, MIDIEnter, arpRange);
     arpRangeFirstPress = 0;
     arpRangeSW = 0;
     arpRangeExitSW = 0;
@@ -1088,20 +1163,14 @@ void updatemultTrig() {
   }
 }
 
+void numberOfVoicesSettingDone(boolean completed) {
+  if (!completed) maxVoicesPREV = 100;  //VST left unknown, send it next time
+}
+
 void updatenumberOfVoicesSetting() {
   if (maxVoices != maxVoicesPREV) {
-
-    midi6CCOut(MIDImaxVoicesSW, 127);
-    midi6CCOut(MIDIDownArrow, 127);
-    for (int maxi = 1; maxi <= (maxVoices - 2); maxi++) {
-      //midi6CCOut(MIDI_R_SW, 127);
-      delay(500);
-      midi6CCOut(MIDIDownArrow, 127);
-    }
-    //midi6CCOut(MIDI_R_SW, 127);
-    delay(500);
-    midi6CCOut(MIDIEnter, 127);
     maxVoicesPREV = maxVoices;
+    macroMenuSelect(MACRO_VOICES, maxVoices, numberOfVoicesSettingDone);
   }
 }
 
@@ -1116,8 +1185,8 @@ void updatenumberOfVoices() {
     myString = myString + " VOICES";
     const char* myChar = myString.c_str();
     showCurrentParameterPage(myChar, "");
-    midi6CCOut(MIDImaxVoicesSW, 127);
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelOpen(MACRO_VOICES);
+    macroPanelKey(MACRO_VOICES, MIDIDownArrow, maxVoices);
     maxVoicesFirstPress++;
   } else if (maxVoicesSW == 1 && maxVoicesFirstPress > 0) {
     maxVoices++;
@@ -1128,7 +1197,7 @@ void updatenumberOfVoices() {
     myString = myString + " VOICES";
     const char* myChar = myString.c_str();
     showCurrentParameterPage(myChar, "");
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelKey(MACRO_VOICES, MIDIDownArrow, maxVoices);
     maxVoicesFirstPress++;
     maxVoices_timer = millis();
   }
@@ -1144,7 +1213,7 @@ void updatemaxVoicesExitSW() {
     const char* myChar = myString.c_str();
     showCurrentParameterPage(myChar, "");
 
-    midi6CCOut(MIDIEnter, 127);
+    macroPanelKey(MACRO_VOICES, MIDIEnter, maxVoices);
     maxVoicesFirstPress = 0;
     maxVoicesSW = 0;
     maxVoicesExitSW = 0;
@@ -1153,6 +1222,10 @@ void updatemaxVoicesExitSW() {
   }
 }
 
+void monoSettingDone(boolean completed) {
+  if (!completed) monoPREV = 100;  //VST left unknown, send it next time
+}
+
 void updateMonoSetting() {
   if (monoMode == 1) {
     sr.writePin(MONO_LED, HIGH);  // LED on
@@ -1162,19 +1235,20 @@ void updateMonoSetting() {
     }
 
     if (mono != monoPREV) {
-      midi6CCOut(MIDImonoSW, 127);
-      midi6CCOut(MIDIDownArrow, 127);
-      for (int i = 1; i < mono; i++) {
-        delay(500);
-        midi6CCOut(MIDIDownArrow, 127);
-      }
-      delay(500);
-      midi6CCOut(MIDIEnter, 127);
       monoPREV = mono;
       polyPREV = 100;
+      macroMenuSelect(MACRO_MONO, mono, monoSettingDone);
     }
   }
-  updatemultTrig();
+  if (!recallDiff) updatemultTrig();  //A diff recall only presses it when it changes
+}
+
+void recallmultTrig() {
+  if (recallDiff) updatemultTrig();
+}
+
+void polySettingDone(boolean completed) {
+  if (!completed) polyPREV = 100;  //VST left unknown, send it next time
 }
 
 void updatePolySetting() {
@@ -1188,16 +1262,9 @@ void updatePolySetting() {
     }
 
     if (poly != polyPREV) {
-      midi6CCOut(MIDIpolySW, 127);
-      midi6CCOut(MIDIDownArrow, 127);
-      for (int i = 1; i < poly; i++) {
-        delay(500);
-        midi6CCOut(MIDIDownArrow, 127);
-      }
-      delay(500);
-      midi6CCOut(MIDIEnter, 127);
       polyPREV = poly;
       monoPREV = 100;
+      macroMenuSelect(MACRO_POLY, poly, polySettingDone);
     }
   }
 }
@@ -1212,8 +1279,8 @@ void updatemonoSW() {
     if (!recallPatchFlag) {
       setMonoModeDisplay();
     }
-    midi6CCOut(MIDImonoSW, 127);
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelOpen(MACRO_MONO);
+    macroPanelKey(MACRO_MONO, MIDIDownArrow, mono);
     monoFirstPress++;
   } else if (monoSW == 1 && monoFirstPress > 0) {
     mono++;
@@ -1223,7 +1290,7 @@ void updatemonoSW() {
     if (!recallPatchFlag) {
       setMonoModeDisplay();
     }
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelKey(MACRO_MONO, MIDIDownArrow, mono);
     monoFirstPress++;
     mono_timer = millis();
   }
@@ -1235,7 +1302,7 @@ void updatemonoExitSW() {
     if (!recallPatchFlag) {
       setMonoModeDisplay();
     }
-    midi6CCOut(MIDIEnter, 127);
+    macroPanelKey(MACRO_MONO, MIDIEnter, mono);
     sr.writePin(MONO_LED, HIGH);  // LED on
     sr.writePin(POLY_LED, LOW);   // LED on
     monoMode = 1;
@@ -1261,8 +1328,8 @@ void updatepolySW() {
     if (!recallPatchFlag) {
       setPolyModeDisplay();
     }
-    midi6CCOut(MIDIpolySW, 127);
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelOpen(MACRO_POLY);
+    macroPanelKey(MACRO_POLY, MIDIDownArrow, poly);
     polyFirstPress++;
   } else if (polySW == 1 && polyFirstPress > 0) {
     poly++;
@@ -1272,7 +1339,7 @@ void updatepolySW() {
     if (!recallPatchFlag) {
       setPolyModeDisplay();
     }
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelKey(MACRO_POLY, MIDIDownArrow, poly);
     polyFirstPress++;
     poly_timer = millis();
   }
@@ -1284,7 +1351,7 @@ void updatepolyExitSW() {
     if (!recallPatchFlag) {
       setPolyModeDisplay();
     }
-    midi6CCOut(MIDIEnter, 127);
+    macroPanelKey(MACRO_POLY, MIDIEnter, poly);
     sr.writePin(POLY_LED, HIGH);  // LED on
     sr.writePin(MONO_LED, LOW);   // LED on
     monoMode = 0;
@@ -1338,14 +1405,14 @@ void setMonoModeDisplay() {
 void sendEscapeKey() {
 
   if ((maxVoices_timer > 0) && (millis() - maxVoices_timer > 3000)) {
-    midi6CCOut(MIDIEscape, 127);
+    macroPanelKey(MACRO_VOICES, MIDIEscape, MENU_UNKNOWN);
     maxVoices_timer = 0;
     maxVoicesFirstPress = 0;
     sr.writePin(NUM_OF_VOICES_LED, LOW);  // LED on
   }
 
   if ((poly_timer > 0) && (millis() - poly_timer > 3000)) {
-    midi6CCOut(MIDIEscape, 127);
+    macroPanelKey(MACRO_POLY, MIDIEscape, MENU_UNKNOWN);
     if (polyExitSW == 0) {
       poly = prevpoly;
     }
@@ -1360,7 +1427,7 @@ void sendEscapeKey() {
   }
 
   if ((mono_timer > 0) && (millis() - mono_timer > 3000)) {
-    midi6CCOut(MIDIEscape, 127);
+    macroPanelKey(MACRO_MONO, MIDIEscape, MENU_UNKNOWN);
     if (monoExitSW == 0) {
       mono = prevmono;
     }
@@ -1375,21 +1442,21 @@ void sendEscapeKey() {
   }
 
   if ((arpRange_timer > 0) && (millis() - arpRange_timer > 3000)) {
-    midi6CCOut(MIDIEscape, 127);
+    macroPanelKey(MACRO_ARP_RANGE, MIDIEscape, MENU_UNKNOWN);
     arpRange_timer = 0;
     arpRangeFirstPress = 0;
     sr.writePin(ARP_RANGE_LED, LOW);  // LED on
   }
 
   if ((arpMode_timer > 0) && (millis() - arpMode_timer > 3000)) {
-    midi6CCOut(MIDIEscape, 127);
+    macroPanelKey(MACRO_ARP_MODE, MIDIEscape, MENU_UNKNOWN);
     arpMode_timer = 0;
     arpModeFirstPress = 0;
     sr.writePin(ARP_MODE_LED, LOW);  // LED on
   }
 
   if ((reverbType_timer > 0) && (millis() - reverbType_timer > 3000)) {
-    midi6CCOut(MIDIEscape, 127);
+    macroPanelKey(MACRO_REVERB_TYPE, MIDIEscape, MENU_UNKNOWN);
     reverbType_timer = 0;
     reverbTypeFirstPress = 0;
     sr.writePin(REVERB_TYPE_LED, LOW);  // LED on
@@ -1397,8 +1464,7 @@ void sendEscapeKey() {
 
   if ((LCD_timer > 0) && (millis() - LCD_timer > 10000)) {
     LCD_timer = 0;
-    LCD.PCF8574_LCDClearLine(LCD.LCDLineNumberOne);
-    LCD.PCF8574_LCDClearLine(LCD.LCDLineNumberTwo);
+    lcdClearScreen();
   }
 }
 
@@ -1610,8 +1676,7 @@ void updatelfoKeybReset() {
 }
 
 void clearLCD() {
-  LCD.PCF8574_LCDClearLine(LCD.LCDLineNumberOne);
-  LCD.PCF8574_LCDClearLine(LCD.LCDLineNumberTwo);
+  lcdClearScreen();
 }
 
 void updatewheelDC() {
@@ -2123,18 +2188,14 @@ void updatereverbSW() {
   }
 }
 
+void reverbTypeDone(boolean completed) {
+  if (!completed) reverbTypePREV = 100;  //VST left unknown, send it next time
+}
+
 void updatereverbType() {
   if (reverbType != reverbTypePREV) {
-
-    midi6CCOut(MIDIreverbTypeSW, 127);
-    midi6CCOut(MIDIDownArrow, 127);
-    for (int i = 1; i < reverbType; i++) {
-      delay(500);
-      midi6CCOut(MIDIDownArrow, 127);
-    }
-    delay(500);
-    midi6CCOut(MIDIEnter, 127);
     reverbTypePREV = reverbType;
+    macroMenuSelect(MACRO_REVERB_TYPE, reverbType, reverbTypeDone);
   }
 }
 
@@ -2155,8 +2216,8 @@ void updatereverbTypeSW() {
         showCurrentParameterPage("     HALL REVERB", "");
       }
     }
-    midi6CCOut(MIDIreverbTypeSW, 127);
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelOpen(MACRO_REVERB_TYPE);
+    macroPanelKey(MACRO_REVERB_TYPE, MIDIDownArrow, reverbType);
     reverbTypeFirstPress++;
   } else if (reverbTypeSW == 1 && reverbTypeFirstPress > 0) {
     reverbType++;
@@ -2174,7 +2235,7 @@ void updatereverbTypeSW() {
         showCurrentParameterPage("     HALL REVERB", "");
       }
     }
-    midi6CCOut(MIDIDownArrow, 127);
+    macroPanelKey(MACRO_REVERB_TYPE, MIDIDownArrow, reverbType);
     reverbTypeFirstPress++;
     reverbType_timer = millis();
   }
@@ -2194,7 +2255,7 @@ void updatereverbTypeExitSW() {
         showCurrentParameterPage("     HALL REVERB", "");
       }
     }
-    midi6CCOut(MIDIEnter, 127);
+    macroPanelKey(MACRO_REVERB_TYPE, MIDIEnter, reverbType);
     reverbTypeFirstPress = 0;
     reverbTypeSW = 0;
     reverbTypeExitSW = 0;
@@ -2453,10 +2514,7 @@ void myControlChange(byte channel, byte control, int value) {
   switch (control) {
 
     case CCmodWheelinput:
-      MIDI.sendControlChange(control, value, channel);
-      if (sendNotes) {
-        usbMIDI.sendControlChange(control, value, channel);
-      }
+      midiRouteSend(midiInSource, ROUTE_EXPRESSION, MIDI_STATUS_CC | (channel - 1), control, value);
       break;
 
     case CCmodWheel:
@@ -3214,6 +3272,7 @@ void myControlChange(byte channel, byte control, int value) {
 }
 
 void myProgramChange(byte channel, byte program) {
+  if (!midiInWanted(channel)) return;
   state = PATCH;
   patchNo = program + 1;
   recallPatch(patchNo);
@@ -3224,10 +3283,17 @@ void myProgramChange(byte channel, byte program) {
 
 void recallPatch(int patchNo) {
   allNotesOff();
+  recallStartMicros = micros();
+  recallTiming = true;
+  recallParamsMicros = 0;
+  macroCancelAll();
 
-  MIDI.sendProgramChange(0, midiOutCh);
-  usbMIDI.sendProgramChange(0, midiOutCh);
-  delay(50);
+  //Once the VST matches the panel only the differences need sending
+  recallDiff = vstInSync;
+  if (!recallDiff) {
+    if (midiOutCh > 0) midiRouteSend(ROUTE_SRC_LOCAL, ROUTE_PROGRAM, MIDI_STATUS_PROGRAM | (midiOutCh - 1), 0, 0);
+    delay(50);
+  }
   recallPatchFlag = true;
   File patchFile = SD.open(String(patchNo).c_str());
   if (!patchFile) {
@@ -3237,11 +3303,189 @@ void recallPatch(int patchNo) {
     recallPatchData(patchFile, data);
     setCurrentPatchData(data);
     patchFile.close();
+    vstInSync = true;
+    Serial.print(recallDiff ? "Diff recall, changed: " : "Full recall, sent: ");
+    Serial.println(recallChanged);
   }
   recallPatchFlag = false;
+  recallDiff = false;
+}
+
+// Patch recall applies parameters in stages, the most audible first. Parameter output
+// goes to the DIN scheduler in the same order so the VST sounds right as early as possible.
+//
+// A full recall resets the VST with program change 0 and relies on that, toggles are only
+// pressed when they are on. A diff recall leaves the VST as it is and only calls the update
+// for values that differ from the live ones, pressing toggles that have to go back off.
+// Entries without a value are VST menus, these already only send when they change.
+#define NO_PRESS 0xFF
+
+struct RecallField {
+  void (*update)();
+  int *value;
+  byte press;          // toggle CC to press when turning off in a diff recall
+  boolean (*pressIf)();  // only press while this holds, NULL to always press
+};
+
+//Mult trig only exists in the VST in mono mode
+boolean recallInMono() {
+  return monoMode;
+}
+
+const RecallField recallOrder[] = {
+  // Levels, filter and envelopes, what is heard first
+  { updatemasterVolume, &masterVolume, NO_PRESS },
+  { updateosc1Level, &osc1Level, NO_PRESS },
+  { updateosc2Level, &osc2Level, NO_PRESS },
+  { updateosc3Level, &osc3Level, NO_PRESS },
+  { updatenoise, &noise, NO_PRESS },
+  { updatefilterCutoff, &filterCutoff, NO_PRESS },
+  { updateemphasis, &emphasis, NO_PRESS },
+  { updatevcfContourAmount, &vcfContourAmount, NO_PRESS },
+  { updatekbTrack, &kbTrack, NO_PRESS },
+  { updatevcaAttack, &vcaAttack, NO_PRESS },
+  { updatevcaDecay, &vcaDecay, NO_PRESS },
+  { updatevcaSustain, &vcaSustain, NO_PRESS },
+  { updatevcaRelease, &vcaRelease, NO_PRESS },
+  { updatevcfAttack, &vcfAttack, NO_PRESS },
+  { updatevcfDecay, &vcfDecay, NO_PRESS },
+  { updatevcfSustain, &vcfSustain, NO_PRESS },
+  { updatevcfRelease, &vcfRelease, NO_PRESS },
+  { updatevcaVelocity, &vcaVelocity, NO_PRESS },
+  { updatevcfVelocity, &vcfVelocity, NO_PRESS },
+  // Oscillator pitch and shape
+  { updateosc1_2, &osc1_2, NO_PRESS },
+  { updateosc1_4, &osc1_4, NO_PRESS },
+  { updateosc1_8, &osc1_8, NO_PRESS },
+  { updateosc1_16, &osc1_16, NO_PRESS },
+  { updateosc2_2, &osc2_2, NO_PRESS },
+  { updateosc2_4, &osc2_4, NO_PRESS },
+  { updateosc2_8, &osc2_8, NO_PRESS },
+  { updateosc2_16, &osc2_16, NO_PRESS },
+  { updateosc3_2, &osc3_2, NO_PRESS },
+  { updateosc3_4, &osc3_4, NO_PRESS },
+  { updateosc3_8, &osc3_8, NO_PRESS },
+  { updateosc3_16, &osc3_16, NO_PRESS },
+  { updateosc1Square, &osc1Square, CCosc1Square },
+  { updateosc1Saw, &osc1Saw, CCosc1Saw },
+  { updateosc1Triangle, &osc1Triangle, CCosc1Triangle },
+  { updateosc2Square, &osc2Square, CCosc2Square },
+  { updateosc2Saw, &osc2Saw, CCosc2Saw },
+  { updateosc2Triangle, &osc2Triangle, CCosc2Triangle },
+  { updateosc3Square, &osc3Square, CCosc3Square },
+  { updateosc3Saw, &osc3Saw, CCosc3Saw },
+  { updateosc3Triangle, &osc3Triangle, CCosc3Triangle },
+  { updateosc2Frequency, &osc2Frequency, NO_PRESS },
+  { updateosc3Frequency, &osc3Frequency, NO_PRESS },
+  { updateosc1PW, &osc1PW, NO_PRESS },
+  { updateosc2PW, &osc2PW, NO_PRESS },
+  { updateosc3PW, &osc3PW, NO_PRESS },
+  { updatemasterTune, &masterTune, NO_PRESS },
+  { updateoscSyncSW, &oscSyncSW, CCoscSyncSW },
+  { updateuniDetune, &uniDetune, NO_PRESS },
+  { updatedriftAmount, &driftAmount, NO_PRESS },
+  // Modulation, keyboard and contour switches
+  { updatelfoSpeed, &lfoSpeed, NO_PRESS },
+  { updatelfoInitialAmount, &lfoInitialAmount, NO_PRESS },
+  { updatelfoOsc3, &lfoOsc3, NO_PRESS },
+  { updatelfoFilterContour, &lfoFilterContour, NO_PRESS },
+  { updatelfoInvert, &lfoInvert, CClfoInvert },
+  { updatelfoTriangle, &lfoTriangle, NO_PRESS },
+  { updatelfoSaw, &lfoSaw, NO_PRESS },
+  { updatelfoRamp, &lfoRamp, NO_PRESS },
+  { updatelfoSquare, &lfoSquare, NO_PRESS },
+  { updatelfoSampleHold, &lfoSampleHold, NO_PRESS },
+  { updatelfoKeybReset, &lfoKeybReset, CClfoKeybReset },
+  { updatelfoSyncSW, &lfoSyncSW, CClfoSyncSW },
+  { updatelfoDestOsc1, &lfoDestOsc1, CClfoDestOsc1 },
+  { updatelfoDestOsc2, &lfoDestOsc2, CClfoDestOsc2 },
+  { updatelfoDestOsc3, &lfoDestOsc3, CClfoDestOsc3 },
+  { updatelfoDestVCA, &lfoDestVCA, CClfoDestVCA },
+  { updatelfoDestPW1, &lfoDestPW1, CClfoDestPW1 },
+  { updatelfoDestPW2, &lfoDestPW2, CClfoDestPW2 },
+  { updatelfoDestPW3, &lfoDestPW3, CClfoDestPW3 },
+  { updatelfoDestFilter, &lfoDestFilter, CClfoDestFilter },
+  { updatecontourOsc3Amt, &contourOsc3Amt, CCcontourOsc3Amt },
+  { updatevoiceModToFilter, &voiceModToFilter, CCvoiceModToFilter },
+  { updatevoiceModToPW2, &voiceModToPW2, CCvoiceModToPW2 },
+  { updatevoiceModToPW1, &voiceModToPW1, CCvoiceModToPW1 },
+  { updatevoiceModToOsc2, &voiceModToOsc2, CCvoiceModToOsc2 },
+  { updatevoiceModToOsc1, &voiceModToOsc1, CCvoiceModToOsc1 },
+  { updatemodWheel, &modWheel, NO_PRESS },
+  { updatewheelDC, &wheelDC, CCwheelDC },
+  { updatebendDepth, &bendDepth, NO_PRESS },
+  { updateGlide, &glide, NO_PRESS },
+  { updateglideSW, &glideSW, CCglideSW },
+  { updateslopeSW, &slopeSW, CCslopeSW },
+  { updatereleaseSW, &releaseSW, CCreleaseSW },
+  { updatekeyboardFollowSW, &keyboardFollowSW, CCkeyboardFollowSW },
+  { updateunconditionalContourSW, &unconditionalContourSW, CCunconditionalContourSW },
+  { updatereturnSW, &returnSW, CCreturnSW },
+  { updatelimitSW, &limitSW, CClimitSW },
+  { updatemodernSW, &modernSW, CCmodernSW },
+  { updatelowSW, &lowSW, CClowSW },
+  { updatekeyboardControlSW, &keyboardControlSW, CCkeyboardControlSW },
+  { updateoctaveDown, &octaveDown, NO_PRESS },
+  { updateoctaveNormal, &octaveNormal, NO_PRESS },
+  { updateoctaveUp, &octaveUp, NO_PRESS },
+  { updatechordMode, &chordMode, CCchordMode },
+  { updatepolySW, &polySW, NO_PRESS },
+  // Effects and arpeggiator
+  { updatephaserSpeed, &phaserSpeed, NO_PRESS },
+  { updatephaserDepth, &phaserDepth, NO_PRESS },
+  { updateensembleRate, &ensembleRate, NO_PRESS },
+  { updateensembleDepth, &ensembleDepth, NO_PRESS },
+  { updateensembleSW, &ensembleSW, CCensembleSW },
+  { updateechoTime, &echoTime, NO_PRESS },
+  { updateechoRegen, &echoRegen, NO_PRESS },
+  { updateechoDamp, &echoDamp, NO_PRESS },
+  { updateechoSpread, &echoSpread, NO_PRESS },
+  { updateechoLevel, &echoLevel, NO_PRESS },
+  { updateechoSW, &echoSW, CCechoSW },
+  { updateechoSyncSW, &echoSyncSW, CCechoSyncSW },
+  { updatereverbLevel, &reverbLevel, NO_PRESS },
+  { updatereverbDamp, &reverbDamp, NO_PRESS },
+  { updatereverbDecay, &reverbDecay, NO_PRESS },
+  { updatereverbSW, &reverbSW, CCreverbSW },
+  { updatearpSpeed, &arpSpeed, NO_PRESS },
+  { updatearpSW, &arpSW, CCarpSW },
+  { updatearpHold, &arpHold, CCarpHold },
+  { updatearpSync, &arpSync, CCarpSync },
+  // VST menus, queued and sent by macroService()
+  { updatePolySetting, NULL, NO_PRESS },
+  { updateMonoSetting, NULL, NO_PRESS },
+  { recallmultTrig, &multTrig, CCmultTrig, recallInMono },
+  { updatenumberOfVoicesSetting, NULL, NO_PRESS },
+  { updatereverbType, NULL, NO_PRESS },
+  { updatearpRangePreset, NULL, NO_PRESS },
+  { updatearpModePreset, NULL, NO_PRESS }
+};
+
+#define RECALL_FIELDS (sizeof(recallOrder) / sizeof(recallOrder[0]))
+
+static int recallPrevious[RECALL_FIELDS];  // live values before the patch was read in
+
+// Reports how long the last recall took to reach the VST, parameters and menus separately
+void checkRecallTiming() {
+  if (!recallTiming) return;
+  if (recallParamsMicros == 0 && dinIdle()) {
+    recallParamsMicros = micros() - recallStartMicros;
+    Serial.print("Recall parameters sent uS: ");
+    Serial.println(recallParamsMicros);
+  }
+  if (recallParamsMicros > 0 && !macroBusy()) {
+    recallMenusMillis = (micros() - recallStartMicros) / 1000;
+    recallTiming = false;
+    Serial.print("Recall menus sent mS: ");
+    Serial.println(recallMenusMillis);
+  }
 }
 
 void setCurrentPatchData(String data[]) {
+  for (unsigned int i = 0; i < RECALL_FIELDS; i++) {
+    if (recallOrder[i].value) recallPrevious[i] = *recallOrder[i].value;
+  }
+
   patchName = data[0];
   glide = data[1].toInt();
   bendDepth = data[2].toInt();
@@ -3413,144 +3657,19 @@ void setCurrentPatchData(String data[]) {
   masterVolumePREV = map(masterVolume, 0, 127, 0, 100);
   lfoSpeedPREV = map(lfoSpeed, 0, 127, 0, 100);
 
-  //Mux1
-
-  updateGlide();
-  updateuniDetune();
-  updatebendDepth();
-  updatelfoOsc3();
-  updatelfoFilterContour();
-  updatearpSpeed();
-  updatephaserSpeed();
-  updatephaserDepth();
-  updatelfoInitialAmount();
-  updatemodWheel();
-  updatelfoSpeed();
-  updateosc2Frequency();
-  updateosc2PW();
-  updateosc1PW();
-  updateosc3Frequency();
-  updateosc3PW();
-
-  //MUX 2
-  updateensembleRate();
-  updateensembleDepth();
-  updateechoTime();
-  updateechoRegen();
-  updateechoDamp();
-  updateechoSpread();
-  updateechoLevel();
-  updatenoise();
-  updateosc3Level();
-  updateosc2Level();
-  updateosc1Level();
-  updatefilterCutoff();
-  updateemphasis();
-  updatevcfDecay();
-  updatevcfAttack();
-  updatevcaAttack();
-
-  //MUX3
-
-  updatereverbLevel();
-  updatereverbDamp();
-  updatereverbDecay();
-  updatedriftAmount();
-  updatevcaVelocity();
-  updatevcaRelease();
-  updatevcaSustain();
-  updatevcaDecay();
-  updatevcfSustain();
-  updatevcfContourAmount();
-  updatevcfRelease();
-  updatekbTrack();
-  updatemasterVolume();
-  updatevcfVelocity();
-  updatemasterTune();
-
-  //Switches
-
-  updatelfoInvert();
-  updatecontourOsc3Amt();
-  updatevoiceModToFilter();
-  updatevoiceModToPW2();
-  updatevoiceModToPW1();
-  updatevoiceModToOsc2();
-  updatevoiceModToOsc1();
-  updatearpSW();
-  updatearpHold();
-  updatearpSync();
-  updatepolySW();
-  updateglideSW();
-  updateoctaveDown();
-  updateoctaveNormal();
-  updateoctaveUp();
-  updatechordMode();
-  updatelfoTriangle();
-  updatelfoSaw();
-  updatelfoRamp();
-  updatelfoSquare();
-  updatelfoSampleHold();
-  updatelfoKeybReset();
-  updatelfoSyncSW();
-  updatewheelDC();
-  updatelfoDestOsc1();
-  updatelfoDestOsc2();
-  updatelfoDestOsc3();
-  updatelfoDestVCA();
-  updatelfoDestPW1();
-  updatelfoDestPW2();
-  updatelfoDestPW3();
-  updatelfoDestFilter();
-
-  updateosc1_2();
-  updateosc1_4();
-  updateosc1_8();
-  updateosc1_16();
-
-  updateosc2_2();
-  updateosc2_4();
-  updateosc2_8();
-  updateosc2_16();
-
-  updateosc3_2();
-  updateosc3_4();
-  updateosc3_8();
-  updateosc3_16();
-
-  updateosc1Square();
-  updateosc1Saw();
-  updateosc1Triangle();
-  updateosc2Square();
-  updateosc2Saw();
-  updateosc2Triangle();
-  updateosc3Square();
-  updateosc3Saw();
-  updateosc3Triangle();
-  updateslopeSW();
-  updateechoSW();
-  updateechoSyncSW();
-  updatereleaseSW();
-  updatekeyboardFollowSW();
-  updateunconditionalContourSW();
-  updatereturnSW();
-  updatereverbSW();
-  updatelimitSW();
-  updatemodernSW();
-  updateensembleSW();
-  updatelowSW();
-  updatekeyboardControlSW();
-  updateoscSyncSW();
-  updatePolySetting();
-  updateMonoSetting();
-  //updatemultTrig();
-  updatenumberOfVoicesSetting();
-  delay(200);
-  updatereverbType();
-  delay(200);
-  updatearpRangePreset();
-  delay(200);
-  updatearpModePreset();
+  //LEDs only go into the shift register buffer here, the next sr.update() sends them in one go
+  recallChanged = 0;
+  for (unsigned int i = 0; i < RECALL_FIELDS; i++) {
+    const RecallField &field = recallOrder[i];
+    if (recallDiff && field.value && *field.value == recallPrevious[i]) continue;
+    recallChanged++;
+    field.update();
+    if (recallDiff && field.press != NO_PRESS && *field.value == 0 && (!field.pressIf || field.pressIf())) {
+      //Update only presses toggles that are on, this one was on in the VST
+      midiCCOut(field.press, 127);
+      if (paramKind[field.press] != PARAM_PULSE) midiCCOut(field.press, 0);
+    }
+  }
 
   //Patchname
   updatePatchname();
@@ -3581,185 +3700,23 @@ String getCurrentPatchData() {
 }
 
 void checkMux() {
+  //Only runs when the background scan has published a new sweep of all 48 pots
+  if (!muxScanGetFrame(muxFrame)) return;
 
-  mux1Read = adc->adc1->analogRead(MUX1_S);
-  mux2Read = adc->adc1->analogRead(MUX2_S);
-  mux3Read = adc->adc1->analogRead(MUX3_S);
+  for (int mux = 0; mux < MUX_COUNT; mux++) {
+    for (int channel = 0; channel < MUXCHANNELS; channel++) {
+      byte cc = potMap[mux][channel].cc;
+      //High res parameters report every step of the 12 bit reading, not just 7 bit changes
+      int potShift = ccIsHiRes(cc) ? 0 : resolutionFrig;
+      if (!potFilterUpdate(mux, channel, muxFrame[mux][channel], potShift)) continue;
+      muxScanPromote(channel);  //Keep the pot being turned on the fast scan
+      if (cc == POT_UNASSIGNED) continue;
 
-  if (mux1Read > (mux1ValuesPrev[muxInput] + QUANTISE_FACTOR) || mux1Read < (mux1ValuesPrev[muxInput] - QUANTISE_FACTOR)) {
-    mux1ValuesPrev[muxInput] = mux1Read;
-    mux1Read = (mux1Read >> resolutionFrig);  // Change range to 0-127
-
-    switch (muxInput) {
-      case MUX1_GLIDE:
-        myControlChange(midiChannel, CCglide, mux1Read);
-        break;
-      case MUX1_UNISON_DETUNE:
-        myControlChange(midiChannel, CCuniDetune, mux1Read);
-        break;
-      case MUX1_BEND_DEPTH:
-        myControlChange(midiChannel, CCbendDepth, mux1Read);
-        break;
-      case MUX1_LFO_OSC3:
-        myControlChange(midiChannel, CClfoOsc3, mux1Read);
-        break;
-      case MUX1_LFO_FILTER_CONTOUR:
-        myControlChange(midiChannel, CClfoFilterContour, mux1Read);
-        break;
-      case MUX1_ARP_RATE:
-        myControlChange(midiChannel, CCarpSpeed, mux1Read);
-        break;
-      case MUX1_PHASER_RATE:
-        myControlChange(midiChannel, CCphaserSpeed, mux1Read);
-        break;
-      case MUX1_PHASER_DEPTH:
-        myControlChange(midiChannel, CCphaserDepth, mux1Read);
-        break;
-      case MUX1_LFO_INITIAL_AMOUNT:
-        myControlChange(midiChannel, CClfoInitialAmount, mux1Read);
-        break;
-      case MUX1_LFO_MOD_WHEEL_AMOUNT:
-        myControlChange(midiChannel, CCmodWheel, mux1Read);
-        break;
-      case MUX1_LFO_RATE:
-        myControlChange(midiChannel, CClfoSpeed, mux1Read);
-        break;
-      case MUX1_OSC2_FREQUENCY:
-        myControlChange(midiChannel, CCosc2Frequency, mux1Read);
-        break;
-      case MUX1_OSC2_PW:
-        myControlChange(midiChannel, CCosc2PW, mux1Read);
-        break;
-      case MUX1_OSC1_PW:
-        myControlChange(midiChannel, CCosc1PW, mux1Read);
-        break;
-      case MUX1_OSC3_FREQUENCY:
-        myControlChange(midiChannel, CCosc3Frequency, mux1Read);
-        break;
-      case MUX1_OSC3_PW:
-        myControlChange(midiChannel, CCosc3PW, mux1Read);
-        break;
+      hiResPending = potFilterValue(mux, channel) << 2;  // 12 bit reading as 14 bit for high res output
+      myControlChange(midiChannel, cc, potFilterValue(mux, channel) >> resolutionFrig);  // Change range to 0-127
+      hiResPending = NO_HIRES_VALUE;
     }
   }
-
-  if (mux2Read > (mux2ValuesPrev[muxInput] + QUANTISE_FACTOR) || mux2Read < (mux2ValuesPrev[muxInput] - QUANTISE_FACTOR)) {
-    mux2ValuesPrev[muxInput] = mux2Read;
-    mux2Read = (mux2Read >> resolutionFrig);  // Change range to 0-127
-
-    switch (muxInput) {
-      case MUX2_ENSEMBLE_RATE:
-        myControlChange(midiChannel, CCensembleRate, mux2Read);
-        break;
-      case MUX2_ENSEMBLE_DEPTH:
-        myControlChange(midiChannel, CCensembleDepth, mux2Read);
-        break;
-      case MUX2_ECHO_TIME:
-        myControlChange(midiChannel, CCechoTime, mux2Read);
-        break;
-      case MUX2_ECHO_FEEDBACK:
-        myControlChange(midiChannel, CCechoRegen, mux2Read);
-        break;
-      case MUX2_ECHO_DAMP:
-        myControlChange(midiChannel, CCechoDamp, mux2Read);
-        break;
-      case MUX2_ECHO_SPREAD:
-        myControlChange(midiChannel, CCechoSpread, mux2Read);
-        break;
-      case MUX2_ECHO_MIX:
-        myControlChange(midiChannel, CCechoLevel, mux2Read);
-        break;
-      case MUX2_NOISE:
-        myControlChange(midiChannel, CCnoise, mux2Read);
-        break;
-      case MUX2_OSC3_LEVEL:
-        myControlChange(midiChannel, CCosc3Level, mux2Read);
-        break;
-      case MUX2_OSC2_LEVEL:
-        myControlChange(midiChannel, CCosc2Level, mux2Read);
-        break;
-      case MUX2_OSC1_LEVEL:
-        myControlChange(midiChannel, CCosc1Level, mux2Read);
-        break;
-      case MUX2_CUTOFF:
-        myControlChange(midiChannel, CCfilterCutoff, mux2Read);
-        break;
-      case MUX2_EMPHASIS:
-        myControlChange(midiChannel, CCemphasis, mux2Read);
-        break;
-      case MUX2_VCF_DECAY:
-        myControlChange(midiChannel, CCvcfDecay, mux2Read);
-        break;
-      case MUX2_VCF_ATTACK:
-        myControlChange(midiChannel, CCvcfAttack, mux2Read);
-        break;
-      case MUX2_VCA_ATTACK:
-        myControlChange(midiChannel, CCvcaAttack, mux2Read);
-        break;
-    }
-  }
-
-  if (mux3Read > (mux3ValuesPrev[muxInput] + QUANTISE_FACTOR) || mux3Read < (mux3ValuesPrev[muxInput] - QUANTISE_FACTOR)) {
-    mux3ValuesPrev[muxInput] = mux3Read;
-    mux3Read = (mux3Read >> resolutionFrig);  // Change range to 0-127
-
-    switch (muxInput) {
-      case MUX3_REVERB_MIX:
-        myControlChange(midiChannel, CCreverbLevel, mux3Read);
-        break;
-      case MUX3_REVERB_DAMP:
-        myControlChange(midiChannel, CCreverbDamp, mux3Read);
-        break;
-      case MUX3_REVERB_DECAY:
-        myControlChange(midiChannel, CCreverbDecay, mux3Read);
-        break;
-      case MUX3_DRIFT:
-        myControlChange(midiChannel, CCdriftAmount, mux3Read);
-        break;
-      case MUX3_VCA_VELOCITY:
-        myControlChange(midiChannel, CCvcaVelocity, mux3Read);
-        break;
-      case MUX3_VCA_RELEASE:
-        myControlChange(midiChannel, CCvcaRelease, mux3Read);
-        break;
-      case MUX3_VCA_SUSTAIN:
-        myControlChange(midiChannel, CCvcaSustain, mux3Read);
-        break;
-      case MUX3_VCA_DECAY:
-        myControlChange(midiChannel, CCvcaDecay, mux3Read);
-        break;
-      case MUX3_VCF_SUSTAIN:
-        myControlChange(midiChannel, CCvcfSustain, mux3Read);
-        break;
-      case MUX3_CONTOUR_AMOUNT:
-        myControlChange(midiChannel, CCvcfContourAmount, mux3Read);
-        break;
-      case MUX3_VCF_RELEASE:
-        myControlChange(midiChannel, CCvcfRelease, mux3Read);
-        break;
-      case MUX3_KB_TRACK:
-        myControlChange(midiChannel, CCkbTrack, mux3Read);
-        break;
-      case MUX3_MASTER_VOLUME:
-        myControlChange(midiChannel, CCmasterVolume, mux3Read);
-        break;
-      case MUX3_VCF_VELOCITY:
-        myControlChange(midiChannel, CCvcfVelocity, mux3Read);
-        break;
-      case MUX3_MASTER_TUNE:
-        myControlChange(midiChannel, CCmasterTune, mux3Read);
-        break;
-    }
-  }
-
-  muxInput++;
-  if (muxInput >= MUXCHANNELS)
-    muxInput = 0;
-
-  digitalWriteFast(MUX_0, muxInput & B0001);
-  digitalWriteFast(MUX_1, muxInput & B0010);
-  digitalWriteFast(MUX_2, muxInput & B0100);
-  digitalWriteFast(MUX_3, muxInput & B1000);
-  delayMicroseconds(75);
 }
 
 void onButtonPress(uint16_t btnIndex, uint8_t btnType) {
@@ -4177,80 +4134,55 @@ void showSettingsPage() {
   showSettingsPage(settings::current_setting(), settings::current_setting_value(), state);
 }
 
-void midi6CCOut(byte cc, byte value) {
-  MIDI6.sendControlChange(cc, value, midiOutCh);  //MIDI DIN is set to Out
-}
-
 void midiCCOut(byte cc, byte value) {
   if (midiOutCh > 0) {
+    byte dest = midiRouteDestinations(ROUTE_SRC_LOCAL, ROUTE_PARAMS) & ~paramOriginExclude();  //Not back where it came from
+    if (dest) {
+      if (ccIsHiRes(cc)) {
+        echoRememberHiRes(cc, hiResValue(value));
+      } else {
+        echoRemember(cc, value);
+      }
+    }
     switch (ccType) {
-      case 0:
+      case CC_TYPE_HIRES:
+        if (ccIsHiRes(cc)) {
+          uint16_t hiRes = hiResValue(value);
+          if (dest & ROUTE_TO_USB) hiResEncode(hiResUSB, cc, hiRes, usbSendCC);
+          if (dest & ROUTE_TO_HOST) hiResEncode(hiResHost, cc, hiRes, hostSendCC);
+          if (dest & ROUTE_TO_DIN) dinQueueHiRes(cc, hiRes);  //Encoded when the scheduler sends it
+          break;
+        }
+        //Parameters without high res output are sent as normal CCs
+        [[fallthrough]];
+      case CC_TYPE_CC:
         {
           switch (cc) {
 
             case CCreleaseSW:
-              if (updateParams) {
-                usbMIDI.sendNoteOn(0, 127, midiOutCh);  //MIDI USB is set to Out
-                usbMIDI.sendNoteOff(0, 0, midiOutCh);   //MIDI USB is set to Out
-              }
-              MIDI.sendNoteOn(0, 127, midiOutCh);  //MIDI DIN is set to Out
-              MIDI.sendNoteOff(0, 0, midiOutCh);   //MIDI USB is set to Out
-              break;
-
             case CCkeyboardFollowSW:
-              if (updateParams) {
-                usbMIDI.sendNoteOn(1, 127, midiOutCh);  //MIDI USB is set to Out
-                usbMIDI.sendNoteOff(1, 0, midiOutCh);   //MIDI USB is set to Out
-              }
-              MIDI.sendNoteOn(1, 127, midiOutCh);  //MIDI DIN is set to Out
-              MIDI.sendNoteOff(1, 0, midiOutCh);   //MIDI USB is set to Out
-              break;
-
             case CCunconditionalContourSW:
-              if (updateParams) {
-                usbMIDI.sendNoteOn(2, 127, midiOutCh);  //MIDI USB is set to Out
-                usbMIDI.sendNoteOff(2, 0, midiOutCh);   //MIDI USB is set to Out
-              }
-              MIDI.sendNoteOn(2, 127, midiOutCh);  //MIDI DIN is set to Out
-              MIDI.sendNoteOff(2, 0, midiOutCh);   //MIDI USB is set to Out
-              break;
-
             case CCreturnSW:
-              if (updateParams) {
-                usbMIDI.sendNoteOn(3, 127, midiOutCh);  //MIDI USB is set to Out
-                usbMIDI.sendNoteOff(3, 0, midiOutCh);   //MIDI USB is set to Out
+              if (dest & ROUTE_TO_USB) {
+                usbOutNoteOn(pulseNotes[cc - CCreleaseSW], 127, midiOutCh);  //MIDI USB is set to Out
+                usbOutNoteOff(pulseNotes[cc - CCreleaseSW], 0, midiOutCh);   //MIDI USB is set to Out
+              }
+              if (dest & ROUTE_TO_HOST) {
+                midi1.sendNoteOn(pulseNotes[cc - CCreleaseSW], 127, midiOutCh);
+                midi1.sendNoteOff(pulseNotes[cc - CCreleaseSW], 0, midiOutCh);
               }
-              MIDI.sendNoteOn(3, 127, midiOutCh);  //MIDI DIN is set to Out
-              MIDI.sendNoteOff(3, 0, midiOutCh);   //MIDI USB is set to Out
+              if (dest & ROUTE_TO_DIN) dinQueueCC(cc, value);  //MIDI DIN is set to Out
               break;
 
             default:
-              if (updateParams) {
-                usbMIDI.sendControlChange(cc, value, midiOutCh);  //MIDI DIN is set to Out
-              }
-              MIDI.sendControlChange(cc, value, midiOutCh);  //MIDI DIN is set to Out
+              if (dest & ROUTE_TO_USB) usbOutControlChange(cc, value, midiOutCh);  //MIDI USB is set to Out
+              if (dest & ROUTE_TO_HOST) midi1.sendControlChange(cc, value, midiOutCh);
+              if (dest & ROUTE_TO_DIN) dinQueueCC(cc, value);  //MIDI DIN is set to Out
               break;
           }
-        }
-      case 1:
-        {
-          // usbMIDI.sendControlChange(99, 0, midiOutCh);      //MIDI DIN is set to Out
-          // usbMIDI.sendControlChange(98, cc, midiOutCh);     //MIDI DIN is set to Out
-          // usbMIDI.sendControlChange(38, value, midiOutCh);  //MIDI DIN is set to Out
-          // usbMIDI.sendControlChange(6, 0, midiOutCh);       //MIDI DIN is set to Out
-
-          // midi1.sendControlChange(99, 0, midiOutCh);      //MIDI DIN is set to Out
-          // midi1.sendControlChange(98, cc, midiOutCh);     //MIDI DIN is set to Out
-          // midi1.sendControlChange(38, value, midiOutCh);  //MIDI DIN is set to Out
-          // midi1.sendControlChange(6, 0, midiOutCh);       //MIDI DIN is set to Out
-
-          // MIDI.sendControlChange(99, 0, midiOutCh);      //MIDI DIN is set to Out
-          // MIDI.sendControlChange(98, cc, midiOutCh);     //MIDI DIN is set to Out
-          // MIDI.sendControlChange(38, value, midiOutCh);  //MIDI DIN is set to Out
-          // MIDI.sendControlChange(6, 0, midiOutCh);       //MIDI DIN is set to Out
           break;
         }
-      case 2:
+      case CC_TYPE_SYSEX:
         {
           break;
         }
@@ -4427,12 +4359,7 @@ void reinitialiseToPanel() {
   //This sets the current patch to be the same as the current hardware panel state - all the pots
   //The four button controls stay the same state
   //This reinialises the previous hardware values to force a re-read
-  muxInput = 0;
-  for (int i = 0; i < MUXCHANNELS; i++) {
-    mux1ValuesPrev[i] = RE_READ;
-    mux2ValuesPrev[i] = RE_READ;
-    mux3ValuesPrev[i] = RE_READ;
-  }
+  potFilterReread();
   patchName = INITPATCHNAME;
   showPatchPage("Initial", "Panel Settings");
 }
@@ -4475,6 +4402,7 @@ void checkEncoder() {
         break;
     }
     encPrevious = encRead;
+    displayChanged();  //Patch lists move without a state change
   } else if ((encCW && encRead < encPrevious - 3) || (!encCW && encRead > encPrevious + 3)) {
     switch (state) {
       case PARAMETER:
@@ -4509,6 +4437,7 @@ void checkEncoder() {
         break;
     }
     encPrevious = encRead;
+    displayChanged();
   }
 }
 
@@ -4529,21 +4458,27 @@ void stopLEDs() {
 }
 
 void loop() {
+  // MIDI is read between each job so notes are passed on without waiting for the whole loop
+  pollMidiIn();
   checkMux();           // Read the sliders and switches
+  pollMidiIn();
   checkSwitches();      // Read the buttons for the program menus etc
   checkEncoder();       // check the encoder status
+  pollMidiIn();
   octoswitch.update();  // read all the buttons for the Quadra
+  pollMidiIn();
   sr.update();          // update all the LEDs in the buttons
-
-  // Read all the MIDI ports
-  myusb.Task();
-  midi1.read();  //USB HOST MIDI Class Compliant
-  MIDI.read(midiChannel);
-  usbMIDI.read(midiChannel);
+  pollMidiIn();
 
   //updateScreen();
 
   stopLEDs();  // blink the wave LEDs once when pressed
   sendEscapeKey();
+  dinService();  // pace parameter changes out of the DIN port
+  macroService();  // VST menu keystrokes on MIDI6
+  checkRecallTiming();
+  serviceUI();  // show the newest parameter change on the LCD and TFT
+  lcdService();  // send the next changed run of LCD characters
   convertIncomingNote();  // read a note when in learn mode and use it to set the values
+  usbOutFlush();          // send this pass of USB MIDI to the host in one go
 }
@@ -0,0 +1,105 @@
+// Timestamped MIDI input ring
+//
+// The input handlers for notes, pitch bend and aftertouch only queue the message here.
+// pollMidiIn() reads every MIDI port until it is empty and then forwards the whole ring,
+// and loop() calls it between each of its slower jobs, so a note never waits for more
+// than one of them.
+// Each message is stamped with the start of the previous poll, the earliest it can have
+// arrived, which makes the measured latency a worst case figure.
+// When the ring is full the oldest bend or aftertouch makes room, then the oldest note on
+// for an incoming note off. A note off is never dropped while the ring holds anything else.
+
+#define MIDI_IN_RING 64
+
+#define MIDI_IN_NOTE_ON 0
+#define MIDI_IN_NOTE_OFF 1
+#define MIDI_IN_PITCH_BEND 2
+#define MIDI_IN_AFTERTOUCH 3
+#define MIDI_IN_POLY_AFTERTOUCH 4
+
+struct MidiInEvent {
+  byte type;
+  byte source;     // ROUTE_SRC_ port it came in on
+  byte channel;
+  byte data1;      // note number, for notes and poly pressure
+  int16_t value;   // velocity, bend or pressure
+  uint32_t stamp;  // micros() the message could first have arrived
+};
+
+static MidiInEvent midiInRing[MIDI_IN_RING];
+static uint8_t midiInHead = 0;
+static uint8_t midiInCount = 0;
+static uint32_t midiInPollStart = 0;      // micros() of the poll in progress
+static uint32_t midiInArrivedAfter = 0;   // micros() of the poll before it
+
+// Counters
+static uint32_t midiInLatencyLast = 0;  // uS from arrival to forwarded, last message
+static uint32_t midiInLatencyMax = 0;   // worst seen
+static uint32_t midiInDropped = 0;     // messages dropped with the ring full
+
+inline void midiInBeginPoll() {
+  midiInArrivedAfter = midiInPollStart;
+  midiInPollStart = micros();
+}
+
+// Removes the oldest message of a type the test accepts, false if there is none
+boolean midiInDropOldest(boolean (*droppable)(byte type)) {
+  for (uint8_t i = 0; i < midiInCount; i++) {
+    if (!droppable(midiInRing[(midiInHead + i) % MIDI_IN_RING].type)) continue;
+    for (uint8_t j = i; j > 0; j--) {
+      midiInRing[(midiInHead + j) % MIDI_IN_RING] = midiInRing[(midiInHead + j - 1) % MIDI_IN_RING];
+    }
+    midiInHead = (midiInHead + 1) % MIDI_IN_RING;
+    midiInCount--;
+    midiInDropped++;
+    return true;
+  }
+  return false;
+}
+
+boolean midiInNotNote(byte type) {
+  return type != MIDI_IN_NOTE_ON && type != MIDI_IN_NOTE_OFF;
+}
+
+boolean midiInNotNoteOff(byte type) {
+  return type != MIDI_IN_NOTE_OFF;
+}
+
+// USB device input is read in omni so a message on another channel can't stop the port
+// being drained, its channel is checked here instead. The DIN library filters for itself
+// and USB host input has never been filtered.
+inline boolean midiInWanted(byte channel) {
+  if (midiInSource != ROUTE_SRC_USB) return true;
+  return midiChannel == MIDI_CHANNEL_OMNI || channel == midiChannel;
+}
+
+void midiInQueue(byte type, byte channel, byte data1, int value) {
+  if (!midiInWanted(channel)) return;
+  if (midiInCount >= MIDI_IN_RING && !midiInDropOldest(midiInNotNote)) {
+    //Only notes waiting, a note off can still take the place of a note on
+    if (type != MIDI_IN_NOTE_OFF || !midiInDropOldest(midiInNotNoteOff)) {
+      midiInDropped++;
+      return;
+    }
+  }
+  midiInRing[(midiInHead + midiInCount) % MIDI_IN_RING] = { type, midiInSource, channel, data1, (int16_t)value, midiInArrivedAfter };
+  midiInCount++;
+}
+
+inline boolean midiInPending() {
+  return midiInCount > 0;
+}
+
+// Takes the oldest message off the ring
+MidiInEvent midiInTake() {
+  MidiInEvent event = midiInRing[midiInHead];
+  midiInHead = (midiInHead + 1) % MIDI_IN_RING;
+  midiInCount--;
+  return event;
+}
+
+// Call once a message has been sent on
+inline void midiInForwarded(const MidiInEvent &event) {
+  midiInLatencyLast = micros() - event.stamp;
+  if (midiInLatencyLast > midiInLatencyMax) midiInLatencyMax = midiInLatencyLast;
+}
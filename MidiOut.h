@@ -0,0 +1,325 @@
+// Paced parameter output for the 5 pin DIN port
+//
+// At 31250 baud the DIN port carries about 1000 CCs a second, a fast pot sweep or a
+// whole panel re-read can produce far more than that. Instead of writing every change
+// to Serial1 as it happens, each parameter has one slot holding only its newest value.
+// dinService() drains the slots from loop() against a token bucket that models the DIN
+// line rate, so values superseded before they could be sent are dropped, not queued, and
+// the UART never backs up into loop(). MIDI on Serial1 uses running status so a run of
+// CCs costs 2 bytes each instead of 3.
+// Slots go out in the order they became pending and a value replaced while waiting keeps
+// its place, so a patch recall reaches the VST in the order the parameters were applied.
+//
+// Slot kinds
+//   PARAM_VALUE   - latest value wins
+//   PARAM_TOGGLE  - 127 followed by 0 is one press of a VST toggle, two presses still
+//                   waiting to be sent cancel each other out
+//   PARAM_PULSE   - each send is one note on/off press (release, keyboard follow etc.)
+// Any slot queued with dinQueueHiRes carries a 14 bit value for the high res encoder.
+//
+// Performance data (notes and controllers from the keyboard) has its own lane. It is a
+// plain FIFO that is written as soon as Serial1 has room, before any parameter, and while
+// it has anything waiting no parameter is sent. Parameters also never leave more than
+// DIN_PARAM_TX_BACKLOG bytes sitting in the UART, so a note is never stuck behind them.
+// Nothing in the lane is dropped, if it fills up the oldest entry is written even though
+// that waits for Serial1.
+
+#define DIN_SLOTS 160              // covers the internal CC numbers above 127
+#define DIN_BYTE_US 320            // 10 bits at 31250 baud
+#define DIN_BURST_BYTES 16         // most the bucket can save up
+#define DIN_MIN_SERIAL_SPACE 6     // never write unless Serial1 can take it without blocking
+#define DIN_PARAM_TX_BACKLOG 6     // most bytes parameters may leave waiting in the UART, about 2mS
+#define DIN_NOTE_RING 32
+
+#define PARAM_VALUE 0
+#define PARAM_TOGGLE 1
+#define PARAM_PULSE 2
+
+#define MIDI_STATUS_CC 0xB0
+#define MIDI_STATUS_NOTE_ON 0x90
+#define MIDI_STATUS_NOTE_OFF 0x80
+#define MIDI_STATUS_PROGRAM 0xC0
+
+struct DinSlot {
+  uint16_t value;     // newest value, 14 bit for high res slots
+  boolean pending;
+  boolean hiRes;
+  boolean armed;      // toggle has seen its 127
+  boolean queued;     // has an entry in dinOrder
+  uint8_t pulses;     // toggle/pulse presses waiting, toggles are kept to 0 or 1
+  uint32_t since;     // micros() it became pending
+};
+
+struct DinNote {
+  byte status;     // with channel
+  byte data1;
+  byte data2;
+  uint32_t stamp;  // micros() queued
+};
+
+// Queue depth and time waiting for each output lane
+struct DinLaneStats {
+  uint16_t maxDepth;
+  uint32_t latencyLast;  // uS from queued to written
+  uint32_t latencyMax;
+  uint32_t sent;
+};
+
+byte paramKind[DIN_SLOTS] = {};
+
+static DinSlot dinSlots[DIN_SLOTS];
+static uint16_t dinPendingCount = 0;
+static byte dinOrder[DIN_SLOTS];          // slots in the order they became pending
+static uint16_t dinOrderHead = 0;
+static uint16_t dinOrderCount = 0;
+static uint32_t dinTokens = DIN_BURST_BYTES * DIN_BYTE_US;  // line time saved up in uS
+static uint32_t dinLastRefill = 0;
+static byte dinRunningStatus = 0;         // last status byte written by the scheduler
+static int dinTxCapacity = 0;             // Serial1 space with nothing waiting
+
+static DinNote dinNotes[DIN_NOTE_RING];
+static uint8_t dinNoteHead = 0;
+static uint8_t dinNoteCount = 0;
+
+DinLaneStats dinNoteLane = {};
+DinLaneStats dinParamLane = {};
+
+// Counters for checking the saving
+static uint32_t dinMessagesQueued = 0;
+static uint32_t dinMessagesSent = 0;
+static uint32_t dinMessagesDropped = 0;
+static uint32_t dinNotesBlocked = 0;      // note lane full, written waiting for Serial1
+
+// Note numbers the VST uses for the pulse style switches, indexed from CCreleaseSW
+const byte pulseNotes[] = { 0, 1, 2, 3 };
+
+void setupMidiOut() {
+  const byte toggles[] = {
+    CCarpHold, CCarpSW, CCarpSync, CCchordMode, CCcontourOsc3Amt, CCechoSW, CCechoSyncSW, CCensembleSW,
+    CCglideSW, CCkeyboardControlSW, CClfoDestFilter, CClfoDestOsc1, CClfoDestOsc2, CClfoDestOsc3, CClfoDestPW1, CClfoDestPW2,
+    CClfoDestPW3, CClfoDestVCA, CClfoInvert, CClfoKeybReset, CClfoSyncSW, CClimitSW, CClowSW, CCmodernSW,
+    CCmultTrig, CCosc1Saw, CCosc1Square, CCosc1Triangle, CCosc2Saw, CCosc2Square, CCosc2Triangle, CCosc3Saw,
+    CCosc3Square, CCosc3Triangle, CCoscSyncSW, CCphaserSW, CCreverbSW, CCslopeSW, CCvoiceModDestVCA, CCvoiceModToFilter,
+    CCvoiceModToOsc1, CCvoiceModToOsc2, CCvoiceModToPW1, CCvoiceModToPW2, CCwheelDC
+  };
+  for (unsigned int i = 0; i < sizeof(toggles); i++) {
+    paramKind[toggles[i]] = PARAM_TOGGLE;
+  }
+  paramKind[CCreleaseSW] = PARAM_PULSE;
+  paramKind[CCkeyboardFollowSW] = PARAM_PULSE;
+  paramKind[CCunconditionalContourSW] = PARAM_PULSE;
+  paramKind[CCreturnSW] = PARAM_PULSE;
+
+  dinLastRefill = micros();
+  dinTxCapacity = Serial1.availableForWrite();
+}
+
+inline void dinMarkPending(byte cc, DinSlot &slot) {
+  if (!slot.pending) {
+    slot.pending = true;
+    slot.since = micros();
+    dinPendingCount++;
+    if (dinPendingCount > dinParamLane.maxDepth) dinParamLane.maxDepth = dinPendingCount;
+    if (!slot.queued) {
+      slot.queued = true;
+      dinOrder[(dinOrderHead + dinOrderCount) % DIN_SLOTS] = cc;
+      dinOrderCount++;
+    }
+  } else {
+    dinMessagesDropped++;
+  }
+}
+
+inline void dinClearPending(DinSlot &slot) {
+  if (slot.pending) {
+    slot.pending = false;
+    dinPendingCount--;
+  }
+}
+
+// Queues a parameter for DIN output, replacing any value still waiting for the same parameter
+void dinQueueCC(byte cc, byte value) {
+  if (cc >= DIN_SLOTS) return;
+  DinSlot &slot = dinSlots[cc];
+  dinMessagesQueued++;
+
+  switch (paramKind[cc]) {
+    case PARAM_TOGGLE:
+      if (value > 0) {
+        slot.armed = true;
+        return;
+      }
+      if (!slot.armed) return;
+      slot.armed = false;
+      slot.pulses ^= 1;
+      if (slot.pulses) {
+        dinMarkPending(cc, slot);
+      } else {
+        //Second press before the first went out, the VST ends up where it is now
+        dinClearPending(slot);
+        dinMessagesDropped += 2;
+      }
+      return;
+
+    case PARAM_PULSE:
+      slot.pulses++;
+      dinMarkPending(cc, slot);
+      return;
+
+    default:
+      slot.value = value;
+      slot.hiRes = false;
+      dinMarkPending(cc, slot);
+      return;
+  }
+}
+
+void dinQueueHiRes(byte cc, uint16_t value) {
+  if (cc >= DIN_SLOTS) return;
+  DinSlot &slot = dinSlots[cc];
+  dinMessagesQueued++;
+  slot.value = value;
+  slot.hiRes = true;
+  dinMarkPending(cc, slot);
+}
+
+// Bytes needed for a channel message given what the scheduler last sent
+inline uint32_t dinMessageCost(byte status) {
+  return (status == dinRunningStatus) ? 2 : 3;
+}
+
+void dinSendCC(byte cc, byte value) {
+  MIDI.sendControlChange(cc, value, midiOutCh);
+  dinRunningStatus = MIDI_STATUS_CC | (midiOutCh - 1);
+  dinMessagesSent++;
+}
+
+inline void dinLaneSent(DinLaneStats &lane, uint32_t since) {
+  lane.latencyLast = micros() - since;
+  if (lane.latencyLast > lane.latencyMax) lane.latencyMax = lane.latencyLast;
+  lane.sent++;
+}
+
+// Writes the oldest performance message, blocks if Serial1 has no room for it
+void dinWriteNote() {
+  DinNote &note = dinNotes[dinNoteHead];
+  uint32_t cost = dinMessageCost(note.status);
+  MIDI.send(midi::MidiType(note.status & 0xF0), note.data1, note.data2, (note.status & 0x0F) + 1);
+  dinRunningStatus = note.status;
+  dinTokens = (dinTokens > cost * DIN_BYTE_US) ? dinTokens - cost * DIN_BYTE_US : 0;  //Line time the parameters can't have
+  dinLaneSent(dinNoteLane, note.stamp);
+  dinNoteHead = (dinNoteHead + 1) % DIN_NOTE_RING;
+  dinNoteCount--;
+}
+
+// Writes waiting performance messages while Serial1 can take them without blocking
+void dinServiceNotes() {
+  while (dinNoteCount > 0) {
+    if (Serial1.availableForWrite() < (int)dinMessageCost(dinNotes[dinNoteHead].status)) return;
+    dinWriteNote();
+  }
+}
+
+// Queues a note on/off or performance controller ahead of all parameters and writes it
+// straight away if Serial1 has room. status includes the channel.
+void dinQueueNote(byte status, byte data1, byte data2) {
+  if (dinNoteCount >= DIN_NOTE_RING) {
+    //Lane full, better to wait for the UART than lose a note off
+    dinWriteNote();
+    dinNotesBlocked++;
+  }
+  dinNotes[(dinNoteHead + dinNoteCount) % DIN_NOTE_RING] = { status, data1, data2, micros() };
+  dinNoteCount++;
+  if (dinNoteCount > dinNoteLane.maxDepth) dinNoteLane.maxDepth = dinNoteCount;
+  dinServiceNotes();
+}
+
+// Worst case bytes the slot will take on the wire
+uint32_t dinSlotCost(byte cc, const DinSlot &slot) {
+  byte ccStatus = MIDI_STATUS_CC | (midiOutCh - 1);
+  if (slot.hiRes) return 2 + 2 + 2 + dinMessageCost(ccStatus);  // NRPN select and data
+  switch (paramKind[cc]) {
+    case PARAM_TOGGLE:
+      return dinMessageCost(ccStatus) + 2;
+    case PARAM_PULSE:
+      return 6;
+    default:
+      return dinMessageCost(ccStatus);
+  }
+}
+
+void dinSendSlot(byte cc, DinSlot &slot) {
+  dinClearPending(slot);
+
+  if (slot.hiRes) {
+    hiResEncode(hiResDIN, cc, slot.value, dinSendCC);
+    return;
+  }
+
+  switch (paramKind[cc]) {
+    case PARAM_TOGGLE:
+      dinSendCC(cc, 127);
+      dinSendCC(cc, 0);
+      slot.pulses = 0;
+      break;
+
+    case PARAM_PULSE:
+      {
+        byte note = pulseNotes[cc - CCreleaseSW];
+        MIDI.sendNoteOn(note, 127, midiOutCh);
+        MIDI.sendNoteOff(note, 0, midiOutCh);
+        dinRunningStatus = MIDI_STATUS_NOTE_OFF | (midiOutCh - 1);
+        dinMessagesSent += 2;
+        if (--slot.pulses > 0) dinMarkPending(cc, slot);  //Every press has to reach the VST, back of the queue
+        break;
+      }
+
+    default:
+      dinSendCC(cc, slot.value);
+      break;
+  }
+}
+
+// Sends waiting performance messages, then drains pending parameters at the DIN line rate.
+// Call once per loop.
+void dinService() {
+  uint32_t now = micros();
+  dinTokens += now - dinLastRefill;
+  dinLastRefill = now;
+  if (dinTokens > DIN_BURST_BYTES * DIN_BYTE_US) dinTokens = DIN_BURST_BYTES * DIN_BYTE_US;
+
+  dinServiceNotes();
+  if (dinNoteCount > 0) return;  //Parameters wait until the note lane is clear
+
+  if (midiOutCh == 0) {
+    //Output is off, nothing will ever go out
+    for (int i = 0; i < DIN_SLOTS; i++) {
+      dinClearPending(dinSlots[i]);
+      dinSlots[i].pulses = 0;
+      dinSlots[i].queued = false;
+    }
+    dinOrderCount = 0;
+    return;
+  }
+
+  while (dinOrderCount > 0) {
+    byte cc = dinOrder[dinOrderHead];
+    DinSlot &slot = dinSlots[cc];
+    if (slot.pending) {
+      uint32_t cost = dinSlotCost(cc, slot);
+      if (dinTokens < cost * DIN_BYTE_US) return;
+      if (Serial1.availableForWrite() < (int)max(cost, (uint32_t)DIN_MIN_SERIAL_SPACE)) return;
+      if (dinTxCapacity - Serial1.availableForWrite() > DIN_PARAM_TX_BACKLOG) return;
+      dinTokens -= cost * DIN_BYTE_US;
+      dinLaneSent(dinParamLane, slot.since);
+    }
+    dinOrderHead = (dinOrderHead + 1) % DIN_SLOTS;
+    dinOrderCount--;
+    slot.queued = false;
+    if (slot.pending) dinSendSlot(cc, slot);  //Cancelled toggles leave an entry behind, skip it
+  }
+}
+
+inline boolean dinIdle() {
+  return dinPendingCount == 0;
+}
@@ -0,0 +1,80 @@
+// MIDI routing table
+//
+// Every message the editor sends is looked up by where it came from and what kind of
+// message it is. The route gives the set of ports it goes to, the incoming channels it
+// passes and an optional channel to send on instead. A message is parsed once into its
+// status and data bytes and the same bytes are handed to each port.
+//
+// The defaults give the fixed routing the editor always had, everything goes to DIN,
+// "Send Notes" adds USB for forwarded notes and expression, "Send Params" adds USB for
+// parameters. Parameters are always sent on the MIDI Out channel.
+
+#define ROUTE_SRC_LOCAL 0  // panel, patch recall
+#define ROUTE_SRC_DIN 1    // 5 pin DIN in
+#define ROUTE_SRC_USB 2    // USB device port, the computer
+#define ROUTE_SRC_HOST 3   // USB host port, a controller plugged into the editor
+#define ROUTE_SOURCES 4
+
+#define ROUTE_NOTES 0       // note on/off
+#define ROUTE_EXPRESSION 1  // pitch bend, aftertouch, mod wheel
+#define ROUTE_PARAMS 2      // parameter CCs
+#define ROUTE_PROGRAM 3     // program change
+#define ROUTE_CLASSES 4
+
+#define ROUTE_TO_DIN 0x01
+#define ROUTE_TO_USB 0x02
+#define ROUTE_TO_HOST 0x04
+
+#define ROUTE_KEEP_CHANNEL 0
+#define ROUTE_ALL_CHANNELS 0xFFFF
+
+struct MidiRoute {
+  byte destinations;  // ROUTE_TO_ bits
+  byte channel;       // 1-16 to send on, ROUTE_KEEP_CHANNEL sends on the incoming one
+  uint16_t channels;  // incoming channels passed, bit 0 is channel 1
+};
+
+MidiRoute midiRoutes[ROUTE_SOURCES][ROUTE_CLASSES];
+
+// Port the message being read came from, set while the inputs are read
+byte midiInSource = ROUTE_SRC_LOCAL;
+
+inline void midiRouteSetUSB(MidiRoute &route, boolean on) {
+  route.destinations = on ? (route.destinations | ROUTE_TO_USB) : (route.destinations & ~ROUTE_TO_USB);
+}
+
+// Follows the Send Notes and Send Params settings
+void midiRouteApplySettings() {
+  for (int source = ROUTE_SRC_DIN; source < ROUTE_SOURCES; source++) {
+    midiRouteSetUSB(midiRoutes[source][ROUTE_NOTES], sendNotes);
+    midiRouteSetUSB(midiRoutes[source][ROUTE_EXPRESSION], sendNotes);
+  }
+  midiRouteSetUSB(midiRoutes[ROUTE_SRC_LOCAL][ROUTE_PARAMS], updateParams);
+}
+
+void setupMidiRoutes() {
+  for (int source = 0; source < ROUTE_SOURCES; source++) {
+    for (int type = 0; type < ROUTE_CLASSES; type++) {
+      midiRoutes[source][type] = { ROUTE_TO_DIN, ROUTE_KEEP_CHANNEL, ROUTE_ALL_CHANNELS };
+    }
+  }
+  midiRoutes[ROUTE_SRC_LOCAL][ROUTE_PROGRAM].destinations = ROUTE_TO_DIN | ROUTE_TO_USB;
+  midiRouteApplySettings();
+}
+
+inline byte midiRouteDestinations(byte source, byte type) {
+  return midiRoutes[source][type].destinations;
+}
+
+// Sends one channel message to every port its route names. status includes the channel.
+void midiRouteSend(byte source, byte type, byte status, byte data1, byte data2) {
+  const MidiRoute &route = midiRoutes[source][type];
+  byte channel = (status & 0x0F) + 1;
+  if (!(route.channels & (1 << (channel - 1)))) return;
+  if (route.channel != ROUTE_KEEP_CHANNEL) channel = route.channel;
+  byte kind = status & 0xF0;
+
+  if (route.destinations & ROUTE_TO_DIN) dinQueueNote(kind | (channel - 1), data1, data2);
+  if (route.destinations & ROUTE_TO_USB) usbOutSend(kind, data1, data2, channel);
+  if (route.destinations & ROUTE_TO_HOST) midi1.send(kind, data1, data2, channel);
+}
@@ -0,0 +1,179 @@
+// Background scan of the three pot MUXs
+//
+// A timer steps through the 16 MUX addresses on its own, converting MUX1 on ADC0
+// and MUX2 on ADC1 in parallel, then MUX3 on ADC0. A finished 48 value sweep is
+// published into a double buffer so loop() only has to pick up the latest frame
+// and never waits on the ADC or on MUX settling.
+//
+// The MUX address pins sit on three different GPIO ports, so the sequencing is done
+// from a short IntervalTimer step rather than chained DMA writes. Each step only
+// pokes a couple of registers and never blocks.
+//
+// Addresses are scheduled by activity. An address where one of its pots moved in the
+// last MUXSCAN_HOT_MS is hot and converted every sweep, idle addresses are converted
+// every MUXSCAN_IDLE_DIVIDER sweeps (staggered) and carry their last reading over
+// otherwise. With nothing hot the step rate also drops to MUXSCAN_IDLE_STEP_US.
+//
+// After the address changes the MUXs get the same 75uS to settle as the old blocking scan
+// gave them, conversions are only started once it has passed. The short step just stops
+// the wait costing more than one step. A step that finds its conversion still running
+// waits for the next one.
+
+#define MUX_COUNT 3
+#define MUXSCAN_STEP_US 12       // timer step, about 7 steps of settling and 2 of conversion per address
+#define MUXSCAN_SETTLE_US 75     // MUX settle time before the first conversion at an address
+#define MUXSCAN_IDLE_STEP_US 96  // step when no pot is moving
+#define MUXSCAN_IDLE_DIVIDER 8   // idle addresses are read every 8th sweep
+#define MUXSCAN_HOT_MS 750       // an address stays hot this long after its last movement
+#define MUXSCAN_PROMOTE 24       // change in ADC counts between reads that makes an address hot
+
+// Phases for each MUX address
+#define MUXSCAN_SETTLE 0   // address set last step, start MUX1 + MUX2
+#define MUXSCAN_READ12 1   // collect MUX1 + MUX2, start MUX3
+#define MUXSCAN_READ3 2    // collect MUX3, move to next address
+
+IntervalTimer muxScanTimer;
+
+static volatile uint16_t muxScanFrames[2][MUX_COUNT][MUXCHANNELS];
+static volatile uint8_t muxScanFront = 0;         // frame loop() reads from
+static volatile uint32_t muxScanFrameCount = 0;   // bumped every completed sweep
+static uint32_t muxScanFrameTaken = 0;            // last sweep loop() consumed
+static uint16_t muxFrame[MUX_COUNT][MUXCHANNELS] = {};  // loop() copy of the latest sweep
+
+static volatile uint8_t muxScanAddress = 0;
+static volatile uint8_t muxScanPhase = MUXSCAN_SETTLE;
+static volatile uint32_t muxScanAddressMicros = 0;  // micros() the address was last set
+static volatile uint32_t muxScanSweepMicros = 0;  // measured sweep period
+static volatile uint32_t muxScanSweepStart = 0;
+
+static volatile uint32_t muxScanSweep = 0;                   // sweep number, used to stagger idle reads
+static volatile uint32_t muxScanHotUntil[MUXCHANNELS] = {};  // millis() until which each address is hot
+static volatile boolean muxScanFast = true;
+static volatile uint32_t muxScanConversions = 0;             // addresses converted, for measuring the saving
+
+inline void muxScanSetAddress(byte address) {
+  digitalWriteFast(MUX_0, address & B0001);
+  digitalWriteFast(MUX_1, address & B0010);
+  digitalWriteFast(MUX_2, address & B0100);
+  digitalWriteFast(MUX_3, address & B1000);
+  muxScanAddressMicros = micros();
+}
+
+inline boolean muxScanIsHot(byte address, uint32_t now) {
+  return (int32_t)(muxScanHotUntil[address] - now) > 0;
+}
+
+// Marks an address as hot, called from the scan when a reading jumps and from loop() when a pot moves
+inline void muxScanPromote(byte address) {
+  muxScanHotUntil[address] = millis() + MUXSCAN_HOT_MS;
+}
+
+inline boolean muxScanDue(byte address, uint32_t now) {
+  return muxScanIsHot(address, now) || ((muxScanSweep + address) % MUXSCAN_IDLE_DIVIDER) == 0;
+}
+
+// Keeps an address hot if any of its pots moved since the previous frame
+inline void muxScanCheckActivity(byte address, volatile uint16_t (*back)[MUXCHANNELS], volatile uint16_t (*front)[MUXCHANNELS]) {
+  for (int mux = 0; mux < MUX_COUNT; mux++) {
+    if (abs((int)back[mux][address] - (int)front[mux][address]) > MUXSCAN_PROMOTE) {
+      muxScanPromote(address);
+      return;
+    }
+  }
+}
+
+// Moves on to the next address that is due, carrying the last reading over for the ones skipped
+void muxScanAdvance() {
+  uint32_t now = millis();
+  while (true) {
+    muxScanAddress++;
+    if (muxScanAddress >= MUXCHANNELS) {
+      muxScanAddress = 0;
+      //Whole panel read, hand the back buffer over to loop()
+      muxScanFront ^= 1;
+      muxScanFrameCount++;
+      muxScanSweep++;
+      uint32_t nowMicros = micros();
+      muxScanSweepMicros = nowMicros - muxScanSweepStart;
+      muxScanSweepStart = nowMicros;
+
+      boolean anyHot = false;
+      for (int i = 0; i < MUXCHANNELS; i++) {
+        if (muxScanIsHot(i, now)) anyHot = true;
+      }
+      if (anyHot != muxScanFast) {
+        muxScanFast = anyHot;
+        muxScanTimer.update(anyHot ? MUXSCAN_STEP_US : MUXSCAN_IDLE_STEP_US);
+      }
+    }
+    if (muxScanDue(muxScanAddress, now)) break;
+
+    volatile uint16_t(*front)[MUXCHANNELS] = muxScanFrames[muxScanFront];
+    volatile uint16_t(*back)[MUXCHANNELS] = muxScanFrames[muxScanFront ^ 1];
+    for (int mux = 0; mux < MUX_COUNT; mux++) {
+      back[mux][muxScanAddress] = front[mux][muxScanAddress];
+    }
+  }
+  muxScanSetAddress(muxScanAddress);
+}
+
+void muxScanStep() {
+  volatile uint16_t(*back)[MUXCHANNELS] = muxScanFrames[muxScanFront ^ 1];
+
+  switch (muxScanPhase) {
+    case MUXSCAN_SETTLE:
+      if (micros() - muxScanAddressMicros < MUXSCAN_SETTLE_US) break;  //MUX outputs still settling
+      adc->adc0->startSingleRead(MUX1_S);
+      adc->adc1->startSingleRead(MUX2_S);
+      muxScanPhase = MUXSCAN_READ12;
+      break;
+
+    case MUXSCAN_READ12:
+      if (!adc->adc0->isComplete() || !adc->adc1->isComplete()) break;
+      back[0][muxScanAddress] = adc->adc0->readSingle();
+      back[1][muxScanAddress] = adc->adc1->readSingle();
+      adc->adc0->startSingleRead(MUX3_S);
+      muxScanPhase = MUXSCAN_READ3;
+      break;
+
+    case MUXSCAN_READ3:
+      if (!adc->adc0->isComplete()) break;
+      back[2][muxScanAddress] = adc->adc0->readSingle();
+      muxScanConversions++;
+      muxScanCheckActivity(muxScanAddress, back, muxScanFrames[muxScanFront]);
+      muxScanAdvance();
+      muxScanPhase = MUXSCAN_SETTLE;
+      break;
+  }
+}
+
+void setupMuxScan() {
+  muxScanAddress = 0;
+  muxScanPhase = MUXSCAN_SETTLE;
+  muxScanSetAddress(0);
+  muxScanSweepStart = micros();
+  muxScanTimer.priority(208);  // below USB and serial MIDI
+  muxScanFast = true;
+  for (int i = 0; i < MUXCHANNELS; i++) {
+    muxScanPromote(i);  //Read the whole panel at full rate to start with
+  }
+  muxScanTimer.begin(muxScanStep, MUXSCAN_STEP_US);
+}
+
+// Copies the newest complete sweep into frame, returns false if nothing new since the last call
+boolean muxScanGetFrame(uint16_t frame[MUX_COUNT][MUXCHANNELS]) {
+  uint32_t count;
+  do {
+    count = muxScanFrameCount;
+    if (count == muxScanFrameTaken) return false;
+    volatile uint16_t(*front)[MUXCHANNELS] = muxScanFrames[muxScanFront];
+    for (int mux = 0; mux < MUX_COUNT; mux++) {
+      for (int i = 0; i < MUXCHANNELS; i++) {
+        frame[mux][i] = front[mux][i];
+      }
+    }
+    //If a sweep finished while copying the buffers were swapped underneath us, copy again
+  } while (count != muxScanFrameCount);
+  muxScanFrameTaken = count;
+  return true;
+}
@@ -0,0 +1,88 @@
+// Parameter change origin and echo suppression
+//
+// Every parameter change is tagged with whether it came in on a MIDI port. One that did
+// updates the panel, LEDs and display and is sent on to the other ports, but never back
+// to the port it came from.
+// The VST or DAW automation often sends a parameter straight back after it is set. Each
+// CC keeps the last few values sent with the time they were sent, an incoming CC that
+// matches one of them within ECHO_WINDOW_MS is taken as that echo and dropped.
+// High res values are remembered as the controller messages they went out as, so the
+// echoed MSB/LSB pair or NRPN select and data entry are each matched on their own number.
+
+#define ORIGIN_LOCAL 0   // panel, pots and patch recall
+#define ORIGIN_REMOTE 1  // came in on a MIDI port, see paramOriginSource
+
+#define ECHO_VALUES 4
+#define ECHO_WINDOW_MS 300
+
+struct EchoWindow {
+  byte value[ECHO_VALUES];
+  uint32_t sentAt[ECHO_VALUES];  // millis(), 0 when the entry is free
+  byte next;
+};
+
+byte paramOrigin = ORIGIN_LOCAL;
+byte paramOriginSource = ROUTE_SRC_LOCAL;  // ROUTE_SRC_ port for ORIGIN_REMOTE
+
+static EchoWindow echoWindows[128];
+
+// Counters
+static uint32_t echoSuppressed = 0;
+static uint32_t remoteChanges = 0;
+
+// Destinations a change with the current origin must not be sent to
+byte paramOriginExclude() {
+  if (paramOrigin != ORIGIN_REMOTE) return 0;
+  switch (paramOriginSource) {
+    case ROUTE_SRC_DIN:
+      return ROUTE_TO_DIN;
+    case ROUTE_SRC_USB:
+      return ROUTE_TO_USB;
+    case ROUTE_SRC_HOST:
+      return ROUTE_TO_HOST;
+  }
+  return 0;
+}
+
+// Records a value sent for cc so its echo can be recognised
+void echoRemember(byte cc, byte value) {
+  if (cc >= 128) return;
+  EchoWindow &window = echoWindows[cc];
+  window.value[window.next] = value;
+  window.sentAt[window.next] = millis() | 1;  //Never 0, that marks a free entry
+  window.next = (window.next + 1) % ECHO_VALUES;
+}
+
+// Records the messages a high res value is sent as, see hiResEncode()
+void echoRememberHiRes(byte cc, uint16_t value) {
+  byte msb = value >> 7;
+  byte lsb = value & 0x7F;
+  if (ccResolution[cc] == CC_RES_14BIT && cc < CC_LSB_OFFSET) {
+    echoRemember(cc, msb);
+    echoRemember(cc + CC_LSB_OFFSET, lsb);
+  } else {
+    echoRemember(NRPN_MSB, 0);
+    echoRemember(NRPN_LSB, cc);
+    echoRemember(DATA_ENTRY_MSB, msb);
+    echoRemember(DATA_ENTRY_LSB, lsb);
+  }
+}
+
+// True if an incoming cc/value is the echo of something just sent, the match is used up
+boolean echoIsOwn(byte cc, byte value) {
+  if (cc >= 128) return false;
+  EchoWindow &window = echoWindows[cc];
+  uint32_t now = millis();
+  for (int i = 0; i < ECHO_VALUES; i++) {
+    if (window.sentAt[i] == 0) continue;
+    if (now - window.sentAt[i] > ECHO_WINDOW_MS) {
+      window.sentAt[i] = 0;
+      continue;
+    }
+    if (window.value[i] == value) {
+      window.sentAt[i] = 0;
+      return true;
+    }
+  }
+  return false;
+}
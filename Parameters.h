@@ -78,7 +78,7 @@ int lfoSpeed, lfoSpeed100, lfoSpeedPREV;
 int lfoSpeedmap = 0;
 float lfoSpeedstr = 0;
 String lfoSpeedstring = "";
-String oldWhichParameter = "                    ";
+const char *oldWhichParameter = "";
 
 int osc2Frequency, osc2Frequency100, osc2FrequencyPREV;
 float osc2Frequencystr = 0;
@@ -0,0 +1,125 @@
+// Per pot smoothing and hysteresis
+//
+// Every MUX channel has its own exponential smoother, a deadband that follows the
+// measured noise of that pot while it is at rest, and settle detection.
+// A pot at rest has to move past its deadband before it is reported. Once moving it
+// tracks with a fast smoother and a small deadband, and when it has been still for
+// settleMillis the final smoothed value is reported and it drops back to rest.
+// Settling is timed rather than counted in sweeps as the scan rate follows pot activity.
+
+struct PotFilterSettings {
+  uint8_t smoothShift;   // smoothing at rest, larger is smoother
+  uint8_t fastShift;     // smoothing while moving
+  uint16_t minDeadband;  // ADC counts
+  uint16_t maxDeadband;  // ADC counts
+  uint8_t settleMillis;  // time without movement before a moving pot is considered settled
+};
+
+struct PotFilterState {
+  int32_t smooth;     // smoothed reading << 4
+  int32_t noise;      // mean deviation at rest << 4
+  uint16_t deadband;  // current deadband in ADC counts
+  uint16_t output;    // last reported value
+  unsigned long lastMove;  // millis() of the last movement while moving
+  boolean moving;
+  boolean reread;     // report the next reading whatever it is
+};
+
+#define POT_FILTER_DEFAULT { 3, 1, 8, 48, 25 }
+#define POT_FILTER_FINE { 4, 1, 6, 32, 40 }  // slow, precise controls such as tuning and cutoff
+#define POT_FILTER_MOVING_DEADBAND 2
+
+PotFilterSettings potFilterSettings[MUX_COUNT][MUXCHANNELS] = {
+  //MUX1
+  { POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT,
+    POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT,
+    POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_FINE,
+    POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_FINE, POT_FILTER_DEFAULT },
+  //MUX2
+  { POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT,
+    POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT,
+    POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_FINE,
+    POT_FILTER_FINE, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT },
+  //MUX3
+  { POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT,
+    POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT,
+    POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_DEFAULT,
+    POT_FILTER_DEFAULT, POT_FILTER_DEFAULT, POT_FILTER_FINE, POT_FILTER_DEFAULT }
+};
+
+static PotFilterState potFilterStates[MUX_COUNT][MUXCHANNELS];
+
+// Forces every pot to be reported on its next reading
+void potFilterReread() {
+  for (int mux = 0; mux < MUX_COUNT; mux++) {
+    for (int i = 0; i < MUXCHANNELS; i++) {
+      potFilterStates[mux][i].reread = true;
+    }
+  }
+}
+
+void setupPotFilter() {
+  for (int mux = 0; mux < MUX_COUNT; mux++) {
+    for (int i = 0; i < MUXCHANNELS; i++) {
+      PotFilterState &st = potFilterStates[mux][i];
+      st.smooth = 0;
+      st.noise = potFilterSettings[mux][i].minDeadband << 4;
+      st.deadband = potFilterSettings[mux][i].minDeadband;
+      st.output = 0;
+      st.lastMove = 0;
+      st.moving = false;
+    }
+  }
+  potFilterReread();
+}
+
+inline uint16_t potFilterValue(byte mux, byte channel) {
+  return potFilterStates[mux][channel].output;
+}
+
+// Feeds one raw 12 bit reading through the filter for mux/channel.
+// Returns true when the reported value changes by at least one step of (1 << shift),
+// so callers only send a CC when the value they send actually differs.
+boolean potFilterUpdate(byte mux, byte channel, int raw, int shift) {
+  const PotFilterSettings &set = potFilterSettings[mux][channel];
+  PotFilterState &st = potFilterStates[mux][channel];
+
+  if (st.reread) {
+    //First reading after start up or a panel re-read, take it as it is
+    st.smooth = raw << 4;
+    st.output = raw;
+    st.moving = false;
+    st.reread = false;
+    return true;
+  }
+
+  int32_t diff = (raw << 4) - st.smooth;
+  st.smooth += diff >> (st.moving ? set.fastShift : set.smoothShift);
+  int value = (st.smooth + 8) >> 4;
+
+  if (!st.moving) {
+    //Learn the noise floor of this pot while nobody is touching it
+    st.noise += (abs(raw - value) * 16 - st.noise) >> 4;
+    st.deadband = constrain((st.noise * 3) >> 4, set.minDeadband, set.maxDeadband);
+  }
+
+  int delta = abs(value - (int)st.output);
+  uint16_t previous = st.output;
+
+  if (!st.moving) {
+    if (delta <= st.deadband) return false;
+    st.moving = true;
+    st.lastMove = millis();
+  }
+
+  if (delta > POT_FILTER_MOVING_DEADBAND) {
+    st.output = value;
+    st.lastMove = millis();
+  } else if (millis() - st.lastMove >= set.settleMillis) {
+    //Settled, report the final resting value and go back to the wide deadband
+    st.output = value;
+    st.moving = false;
+  }
+
+  return (st.output >> shift) != (previous >> shift);
+}
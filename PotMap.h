@@ -0,0 +1,86 @@
+// Pot to parameter mapping
+//
+// potMapDefault is the fixed front panel layout, one entry per MUX channel.
+// checkMux() walks potMap, a working copy that can be re-assigned at runtime
+// with potMapAssign() without recompiling, potMapReset() restores the panel layout.
+
+#define POT_UNASSIGNED 0xFF
+
+struct PotMapping {
+  byte cc;  // parameter controlled by this pot, POT_UNASSIGNED for none
+};
+
+constexpr PotMapping potMapDefault[MUX_COUNT][MUXCHANNELS] = {
+  //MUX1
+  {
+    { CCglide },               // MUX1_GLIDE
+    { CCuniDetune },           // MUX1_UNISON_DETUNE
+    { CCbendDepth },           // MUX1_BEND_DEPTH
+    { CClfoOsc3 },             // MUX1_LFO_OSC3
+    { CClfoFilterContour },    // MUX1_LFO_FILTER_CONTOUR
+    { CCarpSpeed },            // MUX1_ARP_RATE
+    { CCphaserSpeed },         // MUX1_PHASER_RATE
+    { CCphaserDepth },         // MUX1_PHASER_DEPTH
+    { CClfoInitialAmount },    // MUX1_LFO_INITIAL_AMOUNT
+    { CCmodWheel },            // MUX1_LFO_MOD_WHEEL_AMOUNT
+    { CClfoSpeed },            // MUX1_LFO_RATE
+    { CCosc2Frequency },       // MUX1_OSC2_FREQUENCY
+    { CCosc2PW },              // MUX1_OSC2_PW
+    { CCosc1PW },              // MUX1_OSC1_PW
+    { CCosc3Frequency },       // MUX1_OSC3_FREQUENCY
+    { CCosc3PW }               // MUX1_OSC3_PW
+  },
+  //MUX2
+  {
+    { CCensembleRate },        // MUX2_ENSEMBLE_RATE
+    { CCensembleDepth },       // MUX2_ENSEMBLE_DEPTH
+    { CCechoTime },            // MUX2_ECHO_TIME
+    { CCechoRegen },           // MUX2_ECHO_FEEDBACK
+    { CCechoDamp },            // MUX2_ECHO_DAMP
+    { CCechoSpread },          // MUX2_ECHO_SPREAD
+    { CCechoLevel },           // MUX2_ECHO_MIX
+    { CCnoise },               // MUX2_NOISE
+    { CCosc3Level },           // MUX2_OSC3_LEVEL
+    { CCosc2Level },           // MUX2_OSC2_LEVEL
+    { CCosc1Level },           // MUX2_OSC1_LEVEL
+    { CCfilterCutoff },        // MUX2_CUTOFF
+    { CCemphasis },            // MUX2_EMPHASIS
+    { CCvcfDecay },            // MUX2_VCF_DECAY
+    { CCvcfAttack },           // MUX2_VCF_ATTACK
+    { CCvcaAttack }            // MUX2_VCA_ATTACK
+  },
+  //MUX3
+  {
+    { CCreverbLevel },         // MUX3_REVERB_MIX
+    { CCreverbDamp },          // MUX3_REVERB_DAMP
+    { CCreverbDecay },         // MUX3_REVERB_DECAY
+    { CCdriftAmount },         // MUX3_DRIFT
+    { CCvcaVelocity },         // MUX3_VCA_VELOCITY
+    { CCvcaRelease },          // MUX3_VCA_RELEASE
+    { CCvcaSustain },          // MUX3_VCA_SUSTAIN
+    { CCvcaDecay },            // MUX3_VCA_DECAY
+    { CCvcfSustain },          // MUX3_VCF_SUSTAIN
+    { CCvcfContourAmount },    // MUX3_CONTOUR_AMOUNT
+    { CCvcfRelease },          // MUX3_VCF_RELEASE
+    { CCkbTrack },             // MUX3_KB_TRACK
+    { CCmasterVolume },        // MUX3_MASTER_VOLUME
+    { CCvcfVelocity },         // MUX3_VCF_VELOCITY
+    { CCmasterTune },          // MUX3_MASTER_TUNE
+    { POT_UNASSIGNED }         // MUX3_SPARE_15
+  }
+};
+
+PotMapping potMap[MUX_COUNT][MUXCHANNELS];
+
+void potMapReset() {
+  for (int mux = 0; mux < MUX_COUNT; mux++) {
+    for (int i = 0; i < MUXCHANNELS; i++) {
+      potMap[mux][i] = potMapDefault[mux][i];
+    }
+  }
+}
+
+void potMapAssign(byte mux, byte channel, byte cc) {
+  if (mux >= MUX_COUNT || channel >= MUXCHANNELS) return;
+  potMap[mux][channel].cc = cc;
+}
@@ -6,12 +6,21 @@
 #define dc 2   //but certain pairs must NOT be used: 2+10, 6+9, 20+23, 21+22
 #define rst 9  // RST can use any pin
 #define DISPLAYTIMEOUT 1500
+#define UI_FRAME_MS 40  // parameter changes reach the displays at most 25 times a second
+#define DISPLAY_IDLE_MS 5  // how often the display thread looks for a change when there is none
+#define REINITIALISE_SHOW_MS 1000  // how long the reinitialise message stays up
+#define DISPLAY_PIXELS (ST7735_TFTWIDTH * ST7735_TFTHEIGHT_160)
+#define DISPLAY_WIDTH ST7735_TFTHEIGHT_160  // landscape
+#define PATCH_ROW_HEIGHT 23  // one row of the patch lists, including the highlight bar
+#define PATCH_ROW_STRIPS 8
+#define DISPLAY_TEXT 21  // 20 characters and the terminator
 
 #include <Adafruit_GFX.h>
 #include "ST7735_t3.h"  // Local copy from TD1.48 that works for 0.96" IPS 160x80 display
 
 // Section: Included library
 #include "HD44780_LCD_PCF8574.h"
+#include "LcdShadow.h"
 #include <Fonts/Org_01.h>
 #include "Yeysk16pt7b.h"
 #include <Fonts/FreeSansBold18pt7b.h>
@@ -27,26 +36,166 @@
 #define AMP_ENV2 5
 
 ST7735_t3 tft = ST7735_t3(cs, dc, 11, 13, rst);
-HD44780LCD LCD(2, 20, 0x27, &Wire);  // instantiate an object
-
-String currentParameter = "";
-String prevcurrentParameter = "";
-String currentValue = "";
-String prevcurrentValue = "";
-float currentFloatValue = 0.0;
-String currentPgmNum = "";
-String currentPatchName = "";
-String newPatchName = "";
-const char *currentSettingsOption = "";
-const char *currentSettingsValue = "";
-int currentSettingsPart = SETTINGS;
-int paramType = PARAMETER;
+HD44780LCD LCD(2, 20, LCD_I2C_ADDRESS, &Wire);  // instantiate an object
+
+struct DisplayPatchRow {
+  int patchNo;
+  char patchName[DISPLAY_TEXT];
+};
+
+// Everything the display thread shows. loop() fills in displayDraft and displayChanged()
+// publishes a copy through a sequence lock, the display thread only ever renders from
+// its own consistent copy so nothing it reads is changed or freed under it.
+struct DisplayModel {
+  unsigned int state;
+  boolean pot;
+  unsigned long timer;
+  char parameter[DISPLAY_TEXT];
+  char value[DISPLAY_TEXT];
+  float floatValue;
+  int paramType;
+  char pgmNum[DISPLAY_TEXT];
+  char patchName[DISPLAY_TEXT];
+  char newPatchName[DISPLAY_TEXT];
+  const char *settingsOption;  // settings text is constant
+  const char *settingsValue;
+  int settingsPart;
+  DisplayPatchRow first;       // visible rows of the patch lists
+  DisplayPatchRow second;
+  DisplayPatchRow last;
+  DisplayPatchRow beforeLast;
+};
+
+DisplayModel displayDraft = { PARAMETER, false, 0, "", "", 0.0, PARAMETER, "", "", "", "", "", SETTINGS };
+static DisplayModel displayShared = displayDraft;
+static volatile uint32_t displaySeq = 0;  // odd while displayShared is being written, version is displaySeq / 2
+static DisplayModel displayView;          // display thread's copy
 
 boolean voiceOn[NO_OF_VOICES] = { false };
 boolean MIDIClkSignal = false;
 
 unsigned long timer = 0;
 
+// Display thread figures, updated once a second
+uint16_t displayFps = 0;
+uint16_t displayLoad = 0;  // time spent rendering and sending frames, in tenths of a percent
+uint32_t displayPageMicros[SETTINGSVALUE + 1] = {};  // last render time of each page, before sending
+static uint32_t displayFrames = 0;
+static uint32_t displayBusyMicros = 0;
+static unsigned long displayStatsMillis = 0;
+
+void displayCopyPatchRow(DisplayPatchRow &row, const PatchNoAndName &patch) {
+  row.patchNo = patch.patchNo;
+  snprintf(row.patchName, sizeof(row.patchName), "%s", patch.patchName.c_str());
+}
+
+// Publishes displayDraft with the current state and patch list, call from loop() only
+void displayChanged() {
+  displayDraft.state = state;
+  displayDraft.pot = pot;
+  displayDraft.timer = timer;
+  if (!patches.isEmpty()) {
+    displayCopyPatchRow(displayDraft.first, patches.first());
+    displayCopyPatchRow(displayDraft.second, patches.size() > 1 ? patches[1] : patches.last());
+    displayCopyPatchRow(displayDraft.last, patches.last());
+    displayCopyPatchRow(displayDraft.beforeLast, patches.size() > 1 ? patches[patches.size() - 2] : patches.last());
+  }
+
+  displaySeq++;
+  __asm__ volatile("dmb" ::: "memory");
+  displayShared = displayDraft;
+  __asm__ volatile("dmb" ::: "memory");
+  displaySeq++;
+}
+
+// Copies the newest published model into displayView, returns its version
+uint32_t displayTakeModel() {
+  while (1) {
+    uint32_t seq = displaySeq;
+    if (seq & 1) {
+      threads.yield();  //loop() is part way through publishing
+      continue;
+    }
+    __asm__ volatile("dmb" ::: "memory");
+    displayView = displayShared;
+    __asm__ volatile("dmb" ::: "memory");
+    if (displaySeq == seq) return seq >> 1;
+  }
+}
+
+// Two frame buffers, one is drawn on while DMA sends the other to the TFT. The pages only
+// use a few colours so the buffers hold 8 bit palette entries, expanded to RGB565 as they are sent.
+DMAMEM static uint8_t displayBuffers[2][DISPLAY_PIXELS] __attribute__((aligned(32)));
+static uint8_t displayBack = 0;  // buffer being drawn on
+static uint32_t displayWaits = 0;  // frames that had to wait for the previous one to finish sending
+static boolean displayFrontShown = false;  // the screen holds exactly the front buffer
+static uint32_t displayRowsSent = 0;       // for checking the saving against whole frames
+
+// Finds the first and last rows of the new frame that differ from the one on the screen.
+// Pages are redrawn from scratch, so comparing frames finds the real change where
+// tracking drawing calls would always see the whole screen cleared.
+boolean displayChangedRows(int16_t &first, int16_t &last) {
+  const uint8_t *back = displayBuffers[displayBack];
+  const uint8_t *front = displayBuffers[displayBack ^ 1];
+  int16_t width = tft.width();
+  int16_t height = tft.height();
+  size_t rowBytes = width;
+
+  first = 0;
+  while (first < height && memcmp(back + first * width, front + first * width, rowBytes) == 0) first++;
+  if (first == height) return false;
+  last = height - 1;
+  while (last > first && memcmp(back + last * width, front + last * width, rowBytes) == 0) last--;
+  return true;
+}
+
+// Starts sending the rows that changed and moves drawing to the other buffer
+void displaySendFrame() {
+  if (tft.asyncUpdateActive()) displayWaits++;
+  while (tft.asyncUpdateActive()) {
+    threads.yield();  //Previous frame still going out, let loop() run meanwhile
+  }
+
+  int16_t first = 0;
+  int16_t last = tft.height() - 1;
+  if (displayFrontShown && !displayChangedRows(first, last)) return;  //Nothing on the screen would change
+
+  if (!tft.updateScreenAsyncRows(first, last - first + 1)) {
+    tft.updateScreen();
+    displayFrontShown = false;  //Screen now holds the back buffer, send the next frame whole
+    displayRowsSent += tft.height();
+    return;
+  }
+  displayRowsSent += last - first + 1;
+  displayFrontShown = true;
+  displayBack ^= 1;
+  tft.setFrameBuffer8(displayBuffers[displayBack]);
+}
+
+// Newest parameter change waiting for the next UI frame. Changes arriving faster than
+// UI_FRAME_MS overwrite each other here, so MIDI automation costs one render per frame.
+struct LcdParamSlot {
+  int prev;
+  int value;
+  const char *name;  // always a literal
+  boolean pending;
+};
+
+struct ParamPageSlot {
+  char param[21];
+  char value[21];
+  float floatValue;
+  int pType;
+  boolean pending;
+};
+
+LcdParamSlot lcdParam = {};
+ParamPageSlot paramPage = {};
+static unsigned long uiLastFrame = 0;
+static unsigned long uiStateMillis = 0;  // when state last changed
+static char lcdShownParameter[DISPLAY_TEXT] = "";  // parameter page last put on the LCD
+static char lcdShownValue[DISPLAY_TEXT] = "";
+
 void startTimer() {
   if (state == PARAMETER) {
     timer = millis();
@@ -54,14 +203,9 @@ void startTimer() {
 }
 
 void renderBootUpPage() {
-  char testString1[] = "Memory Mode";
-  LCD.PCF8574_LCDGOTO(LCD.LCDLineNumberTwo, 5);
-  LCD.PCF8574_LCDSendString(testString1);
-  char testString2[] = "Editor V1.2";
-  LCD.PCF8574_LCDGOTO(LCD.LCDLineNumberOne, 5);
-  LCD.PCF8574_LCDSendString(testString2);
-  // LCD.PCF8574_LCDGOTO(LCD.LCDLineNumberOne, 12);
-  // LCD.PCF8574_LCDSendString(VERSION);
+  lcdPrint(LCD_LINE_TWO, 5, "Memory Mode");
+  lcdPrint(LCD_LINE_ONE, 5, "Editor V1.2");
+  // lcdPrint(LCD_LINE_ONE, 12, VERSION);
 
   tft.fillScreen(ST7735_BLACK);
   tft.drawRect(42, 30, 46, 11, ST7735_WHITE);
@@ -91,7 +235,7 @@ void renderCurrentPatchPage() {
   tft.setCursor(5, 53);
   tft.setTextColor(ST7735_YELLOW);
   tft.setTextSize(1);
-  tft.println(currentPgmNum);
+  tft.println(displayView.pgmNum);
 
   tft.setTextColor(ST7735_BLACK);
   tft.setFont(&Org_01);
@@ -101,27 +245,89 @@ void renderCurrentPatchPage() {
   tft.setTextColor(ST7735_YELLOW);
   tft.setCursor(1, 90);
   tft.setTextColor(ST7735_WHITE);
-  tft.println(currentPatchName);
+  tft.println(displayView.patchName);
 }
 
+// The parameter page goes on the LCD from loop(), the TFT keeps showing what it had.
+// A pot redraws when its value changes, anything else when the parameter does.
 void renderCurrentParameterPage() {
+  if (displayDraft.state != PARAMETER) return;
+  if (displayDraft.pot) {
+    if (strcmp(displayDraft.value, lcdShownValue) == 0) return;
+    memcpy(lcdShownValue, displayDraft.value, sizeof(lcdShownValue));
+  } else {
+    if (strcmp(displayDraft.parameter, lcdShownParameter) == 0) return;
+    memcpy(lcdShownParameter, displayDraft.parameter, sizeof(lcdShownParameter));
+  }
   LCD_timer = millis();
-  switch (state) {
-    case PARAMETER:
-        LCD.PCF8574_LCDClearLine(LCD.LCDLineNumberOne);
-        char myChar1[currentParameter.length() + 1];
-        currentParameter.toCharArray(myChar1, sizeof(myChar1));
-        LCD.PCF8574_LCDGOTO(LCD.LCDLineNumberOne, 0);
-        LCD.PCF8574_LCDSendString(myChar1);
-
-      //if (currentValue != prevcurrentValue) {
-        LCD.PCF8574_LCDClearLine(LCD.LCDLineNumberTwo);
-        char myChar2[currentValue.length() + 1];
-        currentValue.toCharArray(myChar2, sizeof(myChar2));
-        LCD.PCF8574_LCDGOTO(LCD.LCDLineNumberTwo, 0);
-        LCD.PCF8574_LCDSendString(myChar2);
-      //}
+  lcdClearLine(LCD_LINE_ONE);
+  lcdPrint(LCD_LINE_ONE, 0, displayDraft.parameter);
+  lcdClearLine(LCD_LINE_TWO);
+  lcdPrint(LCD_LINE_TWO, 0, displayDraft.value);
+}
+
+// Patch list rows are kept as drawn strips of frame buffer so scrolling the lists only has
+// to typeset rows that have not been on screen recently. A strip is the full width so it is
+// one contiguous block of the frame buffer.
+struct PatchRowStrip {
+  int patchNo;
+  char patchName[DISPLAY_TEXT];
+  uint16_t background;
+  int16_t baseline;  // text baseline from the top of the strip
+  uint32_t used;     // 0 while empty
+};
+
+static PatchRowStrip patchRowStrips[PATCH_ROW_STRIPS];
+DMAMEM static uint8_t patchRowPixels[PATCH_ROW_STRIPS][PATCH_ROW_HEIGHT * DISPLAY_WIDTH];
+static uint32_t patchRowClock = 0;
+static uint32_t patchRowHits = 0;
+static uint32_t patchRowMisses = 0;
+
+void drawPatchRowText(int16_t baseline, int patchNo, const char *patchName) {
+  tft.setFont(&FreeSans9pt7b);
+  tft.setCursor(0, baseline);
+  tft.setTextColor(ST7735_YELLOW);
+  tft.println(patchNo);
+  tft.setCursor(35, baseline);
+  tft.setTextColor(ST7735_WHITE);
+  tft.println(patchName);
+}
+
+// Draws a patch number and name row from top, with its text baseline at baseline
+void renderPatchRow(int16_t top, int16_t baseline, const DisplayPatchRow &patch, uint16_t background) {
+  uint8_t *frame = tft.getFrameBuffer8();
+  if (frame == NULL || tft.width() != DISPLAY_WIDTH || top < 0 || top + PATCH_ROW_HEIGHT > tft.height()) {
+    if (background != ST7735_BLACK) tft.fillRect(0, top, tft.width(), PATCH_ROW_HEIGHT, background);
+    drawPatchRowText(baseline, patch.patchNo, patch.patchName);
+    return;
   }
+  uint8_t *rows = frame + top * DISPLAY_WIDTH;
+  int16_t offset = baseline - top;
+
+  PatchRowStrip *oldest = &patchRowStrips[0];
+  for (int i = 0; i < PATCH_ROW_STRIPS; i++) {
+    PatchRowStrip &strip = patchRowStrips[i];
+    if (strip.used && strip.patchNo == patch.patchNo && strip.background == background
+        && strip.baseline == offset && strcmp(strip.patchName, patch.patchName) == 0) {
+      memcpy(rows, patchRowPixels[i], sizeof(patchRowPixels[i]));
+      strip.used = ++patchRowClock;
+      patchRowHits++;
+      return;
+    }
+    if (strip.used < oldest->used) oldest = &strip;
+  }
+
+  //Not drawn recently, typeset it and keep the result in place of the least recently used strip
+  patchRowMisses++;
+  tft.fillRect(0, top, DISPLAY_WIDTH, PATCH_ROW_HEIGHT, background);
+  drawPatchRowText(baseline, patch.patchNo, patch.patchName);
+  int slot = oldest - patchRowStrips;
+  memcpy(patchRowPixels[slot], rows, sizeof(patchRowPixels[slot]));
+  oldest->patchNo = patch.patchNo;
+  memcpy(oldest->patchName, patch.patchName, sizeof(oldest->patchName));
+  oldest->background = background;
+  oldest->baseline = offset;
+  oldest->used = ++patchRowClock;
 }
 
 void renderDeletePatchPage() {
@@ -132,20 +338,8 @@ void renderDeletePatchPage() {
   tft.setTextSize(1);
   tft.println("Delete?");
   tft.drawFastHLine(10, 60, tft.width() - 20, ST7735_RED);
-  tft.setFont(&FreeSans9pt7b);
-  tft.setCursor(0, 78);
-  tft.setTextColor(ST7735_YELLOW);
-  tft.println(patches.last().patchNo);
-  tft.setCursor(35, 78);
-  tft.setTextColor(ST7735_WHITE);
-  tft.println(patches.last().patchName);
-  tft.fillRect(0, 85, tft.width(), 23, ST77XX_DARKRED);
-  tft.setCursor(0, 98);
-  tft.setTextColor(ST7735_YELLOW);
-  tft.println(patches.first().patchNo);
-  tft.setCursor(35, 98);
-  tft.setTextColor(ST7735_WHITE);
-  tft.println(patches.first().patchName);
+  renderPatchRow(62, 78, displayView.last, ST7735_BLACK);
+  renderPatchRow(85, 98, displayView.first, ST77XX_DARKRED);
 }
 
 void renderDeleteMessagePage() {
@@ -167,20 +361,8 @@ void renderSavePage() {
   tft.setTextSize(1);
   tft.println("Save?");
   tft.drawFastHLine(10, 60, tft.width() - 20, ST7735_RED);
-  tft.setFont(&FreeSans9pt7b);
-  tft.setCursor(0, 78);
-  tft.setTextColor(ST7735_YELLOW);
-  tft.println(patches[patches.size() - 2].patchNo);
-  tft.setCursor(35, 78);
-  tft.setTextColor(ST7735_WHITE);
-  tft.println(patches[patches.size() - 2].patchName);
-  tft.fillRect(0, 85, tft.width(), 23, ST77XX_DARKRED);
-  tft.setCursor(0, 98);
-  tft.setTextColor(ST7735_YELLOW);
-  tft.println(patches.last().patchNo);
-  tft.setCursor(35, 98);
-  tft.setTextColor(ST7735_WHITE);
-  tft.println(patches.last().patchName);
+  renderPatchRow(62, 78, displayView.beforeLast, ST7735_BLACK);
+  renderPatchRow(85, 98, displayView.last, ST77XX_DARKRED);
 }
 
 void renderReinitialisePage() {
@@ -204,37 +386,19 @@ void renderPatchNamingPage() {
   tft.drawFastHLine(10, 62, tft.width() - 20, ST7735_RED);
   tft.setTextColor(ST7735_WHITE);
   tft.setCursor(5, 90);
-  tft.println(newPatchName);
+  tft.println(displayView.newPatchName);
 }
 
 void renderRecallPage() {
   tft.fillScreen(ST7735_BLACK);
-  tft.setFont(&FreeSans9pt7b);
-  tft.setCursor(0, 45);
-  tft.setTextColor(ST7735_YELLOW);
-  tft.println(patches.last().patchNo);
-  tft.setCursor(35, 45);
-  tft.setTextColor(ST7735_WHITE);
-  tft.println(patches.last().patchName);
-
-  tft.fillRect(0, 56, tft.width(), 23, 0xA000);
-  tft.setCursor(0, 72);
-  tft.setTextColor(ST7735_YELLOW);
-  tft.println(patches.first().patchNo);
-  tft.setCursor(35, 72);
-  tft.setTextColor(ST7735_WHITE);
-  tft.println(patches.first().patchName);
-
-  tft.setCursor(0, 98);
-  tft.setTextColor(ST7735_YELLOW);
-  patches.size() > 1 ? tft.println(patches[1].patchNo) : tft.println(patches.last().patchNo);
-  tft.setCursor(35, 98);
-  tft.setTextColor(ST7735_WHITE);
-  patches.size() > 1 ? tft.println(patches[1].patchName) : tft.println(patches.last().patchName);
+  renderPatchRow(29, 45, displayView.last, ST7735_BLACK);
+  renderPatchRow(56, 72, displayView.first, ST77XX_DARKRED);
+  renderPatchRow(82, 98, displayView.second, ST7735_BLACK);
 }
 
 void showRenamingPage(String newName) {
-  newPatchName = newName;
+  snprintf(displayDraft.newPatchName, sizeof(displayDraft.newPatchName), "%s", newName.c_str());
+  displayChanged();
 }
 
 void renderUpDown(uint16_t x, uint16_t y, uint16_t colour) {
@@ -250,29 +414,42 @@ void renderSettingsPage() {
   tft.setTextColor(ST7735_YELLOW);
   tft.setTextSize(1);
   tft.setCursor(0, 53);
-  tft.println(currentSettingsOption);
-  if (currentSettingsPart == SETTINGS) renderUpDown(140, 42, ST7735_YELLOW);
+  tft.println(displayView.settingsOption);
+  if (displayView.settingsPart == SETTINGS) renderUpDown(140, 42, ST7735_YELLOW);
   tft.drawFastHLine(10, 62, tft.width() - 20, ST7735_RED);
   tft.setTextColor(ST7735_WHITE);
   tft.setCursor(5, 90);
-  tft.println(currentSettingsValue);
-  if (currentSettingsPart == SETTINGSVALUE) renderUpDown(140, 80, ST7735_WHITE);
+  tft.println(displayView.settingsValue);
+  if (displayView.settingsPart == SETTINGSVALUE) renderUpDown(140, 80, ST7735_WHITE);
 }
 
 void showCurrentParameterPage(const char *param, float val, int pType) {
-  currentParameter = param;
-  currentValue = String(val);
-  currentFloatValue = val;
-  paramType = pType;
-  startTimer();
+  snprintf(paramPage.param, sizeof(paramPage.param), "%s", param);
+  dtostrf(val, 0, 2, paramPage.value);
+  paramPage.floatValue = val;
+  paramPage.pType = pType;
+  paramPage.pending = true;
 }
 
 void showCurrentParameterPage(const char *param, String val, int pType) {
   if (state == SETTINGS || state == SETTINGSVALUE) state = PARAMETER;  //Exit settings page if showing
-  currentParameter = param;
-  currentValue = val;
-  paramType = pType;
+  snprintf(paramPage.param, sizeof(paramPage.param), "%s", param);
+  snprintf(paramPage.value, sizeof(paramPage.value), "%s", val.c_str());
+  paramPage.floatValue = displayDraft.floatValue;
+  paramPage.pType = pType;
+  paramPage.pending = true;
+}
+
+// Hands the newest parameter page to the display thread
+void publishParamPage() {
+  paramPage.pending = false;
+  memcpy(displayDraft.parameter, paramPage.param, sizeof(displayDraft.parameter));
+  memcpy(displayDraft.value, paramPage.value, sizeof(displayDraft.value));
+  displayDraft.floatValue = paramPage.floatValue;
+  displayDraft.paramType = paramPage.pType;
   startTimer();
+  displayChanged();
+  renderCurrentParameterPage();
 }
 
 void showCurrentParameterPage(const char *param, String val) {
@@ -280,36 +457,52 @@ void showCurrentParameterPage(const char *param, String val) {
 }
 
 void showPatchPage(String number, String patchName) {
-  currentPgmNum = number;
-  currentPatchName = patchName;
+  snprintf(displayDraft.pgmNum, sizeof(displayDraft.pgmNum), "%s", number.c_str());
+  snprintf(displayDraft.patchName, sizeof(displayDraft.patchName), "%s", patchName.c_str());
+  displayChanged();
 }
 
 void showSettingsPage(const char *option, const char *value, int settingsPart) {
-  currentSettingsOption = option;
-  currentSettingsValue = value;
-  currentSettingsPart = settingsPart;
+  displayDraft.settingsOption = option;
+  displayDraft.settingsValue = value;
+  displayDraft.settingsPart = settingsPart;
+  displayChanged();
+}
+
+void displayStatsUpdate() {
+  unsigned long now = millis();
+  if (now - displayStatsMillis < 1000) return;
+  displayFps = displayFrames * 1000 / (now - displayStatsMillis);
+  displayLoad = displayBusyMicros / (now - displayStatsMillis);
+  displayFrames = 0;
+  displayBusyMicros = 0;
+  displayStatsMillis = now;
 }
 
 void displayThread() {
   threads.delay(2000);  //Give bootup page chance to display
+  uint32_t renderedVersion = displayTakeModel() - 1;
+  unsigned int renderedState = displayView.state;
+  boolean renderedTimeout = false;
   while (1) {
-    switch (state) {
+    displayStatsUpdate();
+    uint32_t version = displayTakeModel();
+    boolean timedOut = (millis() - displayView.timer) > DISPLAYTIMEOUT;
+    if (version == renderedVersion && displayView.state == renderedState && timedOut == renderedTimeout) {
+      threads.delay(DISPLAY_IDLE_MS);  //Nothing new to show, leave the time to loop()
+      continue;
+    }
+    renderedVersion = version;
+    renderedState = displayView.state;
+    renderedTimeout = timedOut;
+
+    uint32_t start = micros();
+    switch (renderedState) {
       case PARAMETER:
-        if ((millis() - timer) > DISPLAYTIMEOUT) {
+        if (timedOut) {
           renderCurrentPatchPage();
         } else {
-          if (pot) {
-          if (currentValue != prevcurrentValue) {
-            renderCurrentParameterPage();
-            prevcurrentValue = currentValue;
-          }
-          }
-          if (!pot) {
-            if (currentParameter != prevcurrentParameter) {
-              renderCurrentParameterPage();
-              prevcurrentParameter = currentParameter;
-            }
-          }
+          continue;  //The parameter page is on the LCD, loop() draws it, the TFT is left as it is
         }
         break;
       case RECALL:
@@ -320,9 +513,6 @@ void displayThread() {
         break;
       case REINITIALISE:
         renderReinitialisePage();
-        tft.updateScreen();  //update before delay
-        threads.delay(1000);
-        state = PARAMETER;
         break;
       case PATCHNAMING:
         renderPatchNamingPage();
@@ -341,11 +531,15 @@ void displayThread() {
         renderSettingsPage();
         break;
     }
-    tft.updateScreen();
+    displayPageMicros[renderedState] = micros() - start;
+    displaySendFrame();
+    displayFrames++;
+    displayBusyMicros += micros() - start;
   }
 }
 
 void setupDisplay() {
+  tft.setFrameBuffer8(displayBuffers[displayBack]);
   tft.useFrameBuffer(true);
   tft.initR(INITR_BLACKTAB);
   tft.setRotation(3);
@@ -353,7 +547,9 @@ void setupDisplay() {
 
   LCD.PCF8574_LCDInit(LCD.LCDCursorTypeOff);
   LCD.PCF8574_LCDClearScreen();
+  setupLcdShadow();
 
   renderBootUpPage();
+  lcdFlush();
   threads.addThread(displayThread);
 }
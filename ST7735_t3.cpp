@@ -35,6 +35,11 @@ volatile short _dma_dummy_rx;
 
 ST7735_t3 *ST7735_t3::_dmaActiveDisplay[3] = {0, 0, 0};
 
+DMAMEM ST77XXGlyphEntry ST7735_t3::_glyph_cache[ST77XX_GLYPH_CACHE_ENTRIES];
+bool ST7735_t3::_glyph_cache_ready = false;
+uint32_t ST7735_t3::_glyph_cache_hits = 0;
+uint32_t ST7735_t3::_glyph_cache_misses = 0;
+
 #if defined(__IMXRT1062__)  // Teensy 4.x
 // On T4 Setup the buffers to be used one per SPI buss... 
 // This way we make sure it is hopefully in uncached memory
@@ -50,6 +55,10 @@ ST7735_t3::ST7735_t3(uint8_t cs, uint8_t rs, uint8_t sid, uint8_t sclk, uint8_t
 {
   #ifdef ENABLE_ST77XX_FRAMEBUFFER
     _pfbtft = NULL; 
+    _pfbtft_async = NULL;
+    _pfbtft8 = NULL;
+    _pfbtft8_async = NULL;
+    _palette_count = 0;
     _use_fbtft = 0;           // Are we in frame buffer mode?
   _we_allocated_buffer = NULL;
   _dma_state = 0;
@@ -525,7 +534,8 @@ void ST7735_t3::drawPixel(int16_t x, int16_t y, uint16_t color)
   if ((x < 0) ||(x >= _width) || (y < 0) || (y >= _height)) return;
   #ifdef ENABLE_ST77XX_FRAMEBUFFER
   if (_use_fbtft) {
-    _pfbtft[y*_width + x] = color;
+    if (_pfbtft8) _pfbtft8[y*_width + x] = colorIndex(color);
+    else _pfbtft[y*_width + x] = color;
 
   } else 
   #endif
@@ -545,7 +555,14 @@ void ST7735_t3::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
   if ((x >= _width) || (y >= _height)) return;
   if ((y+h-1) >= _height) h = _height-y;
   #ifdef ENABLE_ST77XX_FRAMEBUFFER
-  if (_use_fbtft) {
+  if (_use_fbtft && _pfbtft8) {
+    uint8_t index = colorIndex(color);
+    uint8_t * pfbPixel = &_pfbtft8[ y*_width + x];
+    while (h--) {
+      *pfbPixel = index;
+      pfbPixel += _width;
+    }
+  } else if (_use_fbtft) {
     uint16_t * pfbPixel = &_pfbtft[ y*_width + x];
     while (h--) {
       *pfbPixel = color;
@@ -573,7 +590,9 @@ void ST7735_t3::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
   if ((x+w-1) >= _width)  w = _width-x;
 
   #ifdef ENABLE_ST77XX_FRAMEBUFFER
-  if (_use_fbtft) {
+  if (_use_fbtft && _pfbtft8) {
+    memset(&_pfbtft8[ y*_width + x], colorIndex(color), w);
+  } else if (_use_fbtft) {
     if ((x&1) || (w&1)) {
       uint16_t * pfbPixel = &_pfbtft[ y*_width + x];
       while (w--) {
@@ -604,6 +623,91 @@ void ST7735_t3::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
 
 
 
+// Returns the runs for a glyph, turning its bitmap into runs the first time it is seen.
+// Returns NULL if the glyph has too many runs to cache.
+const ST77XXGlyphEntry *ST7735_t3::glyphCacheLookup(const GFXfont *font, uint8_t c)
+{
+  if (!_glyph_cache_ready) {
+    // DMAMEM is not cleared at start up
+    memset(_glyph_cache, 0, sizeof(_glyph_cache));
+    _glyph_cache_ready = true;
+  }
+  ST77XXGlyphEntry *entry = &_glyph_cache[((((uintptr_t)font) >> 2) * 31 + c) % ST77XX_GLYPH_CACHE_ENTRIES];
+  if (entry->font == font && entry->c == c) {
+    _glyph_cache_hits++;
+    return entry;
+  }
+  _glyph_cache_misses++;
+
+  // Same bit order as Adafruit_GFX::drawChar, rows are not byte aligned
+  GFXglyph *glyph = &font->glyph[c - font->first];
+  const uint8_t *bitmap = &font->bitmap[glyph->bitmapOffset];
+  int8_t xo = glyph->xOffset;
+  int8_t yo = glyph->yOffset;
+  uint8_t bits = 0, bit = 0, count = 0;
+  for (uint8_t yy = 0; yy < glyph->height; yy++) {
+    int16_t run = -1;
+    for (uint8_t xx = 0; xx <= glyph->width; xx++) {
+      bool set = false;
+      if (xx < glyph->width) {
+        if (!(bit++ & 7)) bits = *bitmap++;
+        set = bits & 0x80;
+        bits <<= 1;
+      }
+      if (set && run < 0) {
+        run = xx;
+      } else if (!set && run >= 0) {
+        if (count == ST77XX_GLYPH_MAX_SPANS) {
+          entry->font = NULL;
+          return NULL;
+        }
+        entry->spans[count].x = xo + run;
+        entry->spans[count].y = yo + yy;
+        entry->spans[count].len = xx - run;
+        count++;
+        run = -1;
+      }
+    }
+  }
+  entry->font = font;
+  entry->c = c;
+  entry->count = count;
+  return entry;
+}
+
+size_t ST7735_t3::write(uint8_t c)
+{
+  #ifdef ENABLE_ST77XX_FRAMEBUFFER
+  if (gfxFont && _use_fbtft && textsize_x == 1 && textsize_y == 1 && c != '\n' && c != '\r'
+      && c >= gfxFont->first && c <= gfxFont->last) {
+    const ST77XXGlyphEntry *entry = glyphCacheLookup(gfxFont, c);
+    if (entry) {
+      GFXglyph *glyph = &gfxFont->glyph[c - gfxFont->first];
+      if (glyph->width > 0 && glyph->height > 0) {
+        if (wrap && ((cursor_x + glyph->xOffset + glyph->width) > _width)) {
+          cursor_x = 0;
+          cursor_y += gfxFont->yAdvance;
+        }
+        for (uint8_t i = 0; i < entry->count; i++) {
+          int16_t x = cursor_x + entry->spans[i].x;
+          int16_t y = cursor_y + entry->spans[i].y;
+          int16_t len = entry->spans[i].len;
+          if (y < 0 || y >= _height) continue;
+          if (x < 0) {
+            len += x;
+            x = 0;
+          }
+          if (len > 0) drawFastHLine(x, y, len, textcolor);
+        }
+      }
+      cursor_x += glyph->xAdvance;
+      return 1;
+    }
+  }
+  #endif
+  return Adafruit_GFX::write(c);
+}
+
 void ST7735_t3::fillScreen(uint16_t color)
 {
   fillRect(0, 0,  _width, _height, color);
@@ -619,7 +723,14 @@ void ST7735_t3::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t co
   if ((x + w - 1) >= _width)  w = _width  - x;
   if ((y + h - 1) >= _height) h = _height - y;
   #ifdef ENABLE_ST77XX_FRAMEBUFFER
-  if (_use_fbtft) {
+  if (_use_fbtft && _pfbtft8) {
+    uint8_t index = colorIndex(color);
+    uint8_t * pfbPixel_row = &_pfbtft8[ y*_width + x];
+    for (;h>0; h--) {
+      memset(pfbPixel_row, index, w);
+      pfbPixel_row += _width;
+    }
+  } else if (_use_fbtft) {
     if ((x&1) || (w&1)) {
       uint16_t * pfbPixel_row = &_pfbtft[ y*_width + x];
       for (;h>0; h--) {
@@ -878,9 +989,9 @@ void ST7735_t3::process_dma_interrupt(void) {
       }
     }
     if (_dma_sub_frame_count & 1) {
-      memcpy(_dma_data[_spi_num]._dma_buffer1, &_pfbtft[_dma_pixel_index], _dma_buffer_size*2);
+      copyToDMABuffer(_dma_data[_spi_num]._dma_buffer1, _dma_pixel_index);
     } else {      
-      memcpy(_dma_data[_spi_num]._dma_buffer2, &_pfbtft[_dma_pixel_index], _dma_buffer_size*2);
+      copyToDMABuffer(_dma_data[_spi_num]._dma_buffer2, _dma_pixel_index);
     }
     _dma_pixel_index += _dma_buffer_size;
     if (_dma_pixel_index >= (_count_pixels))
@@ -897,6 +1008,54 @@ void ST7735_t3::process_dma_interrupt(void) {
 //=======================================================================
 // Add optinal support for using frame buffer to speed up complex outputs
 //=======================================================================
+// Fills a DMA bounce buffer from the frame being sent, expanding 8 bit pixels through the palette
+void ST7735_t3::copyToDMABuffer(uint16_t *dma_buffer, uint32_t pixel_index)
+{
+  if (_pfbtft8_async) {
+    const uint8_t *src = &_pfbtft8_async[pixel_index];
+    for (uint16_t i = 0; i < _dma_buffer_size; i++) {
+      dma_buffer[i] = _palette[src[i]];
+    }
+  } else {
+    memcpy(dma_buffer, &_pfbtft_async[pixel_index], _dma_buffer_size*2);
+  }
+}
+
+void ST7735_t3::setFrameBuffer8(uint8_t *frame_buffer)
+{
+  _pfbtft8 = frame_buffer;
+}
+
+uint8_t ST7735_t3::colorIndex(uint16_t color)
+{
+  if (_palette_count && color == _palette_last_color) return _palette_last_index;
+  uint16_t index;
+  for (index = 0; index < _palette_count; index++) {
+    if (_palette[index] == color) break;
+  }
+  if (index == _palette_count) {
+    if (_palette_count < 256) {
+      _palette[_palette_count++] = color;
+    } else {
+      // Palette full, use the closest colour there is
+      uint32_t best = 0xFFFFFFFF;
+      for (uint16_t i = 0; i < 256; i++) {
+        int dr = ((color >> 11) & 0x1F) - ((_palette[i] >> 11) & 0x1F);
+        int dg = ((color >> 5) & 0x3F) - ((_palette[i] >> 5) & 0x3F);
+        int db = (color & 0x1F) - (_palette[i] & 0x1F);
+        uint32_t dist = dr*dr*4 + dg*dg + db*db*4;
+        if (dist < best) {
+          best = dist;
+          index = i;
+        }
+      }
+    }
+  }
+  _palette_last_color = color;
+  _palette_last_index = index;
+  return index;
+}
+
 void ST7735_t3::setFrameBuffer(uint16_t *frame_buffer) 
 {
   _pfbtft = frame_buffer;
@@ -909,11 +1068,11 @@ void ST7735_t3::setFrameBuffer(uint16_t *frame_buffer)
 uint8_t ST7735_t3::useFrameBuffer(boolean b)    // use the frame buffer?  First call will allocate
 {
   if (b) {
+    // Note: If called before init maybe larger than we need
+    _count_pixels =  _width * _height;
     // First see if we need to allocate buffer
-    if (_pfbtft == NULL) {
+    if (_pfbtft == NULL && _pfbtft8 == NULL) {
       // Hack to start frame buffer on 32 byte boundary
-      // Note: If called before init maybe larger than we need
-      _count_pixels =  _width * _height;
       _we_allocated_buffer = (uint16_t *)malloc(_count_pixels*2+32);
       if (_we_allocated_buffer == NULL)
         return 0; // failed 
@@ -948,6 +1107,14 @@ void ST7735_t3::updateScreen(void)          // call to say update the screen now
 
     // BUGBUG doing as one shot.  Not sure if should or not or do like
     // main code and break up into transactions...
+    if (_pfbtft8) {
+      for (uint32_t i = 0; i < (_count_pixels)-1; i++) {
+        writedata16(_palette[_pfbtft8[i]]);
+      }
+      writedata16_last(_palette[_pfbtft8[(_count_pixels)-1]]);
+      endSPITransaction();
+      return;
+    }
     uint16_t *pfbtft_end = &_pfbtft[(_count_pixels)-1]; // setup 
     uint16_t *pftbft = _pfbtft;
 
@@ -1002,6 +1169,12 @@ void  ST7735_t3::initDMASettings(void)
     _dma_cnt_sub_frames_per_frame = (_count_pixels) / _dma_buffer_size;   
   }
 
+  // Partial updates have to send whole sub frames, and the ISR can only stop after at least three
+  _dma_band_rows = 1;
+  while (((_dma_band_rows * _width) % _dma_buffer_size) || ((_dma_band_rows * _width) < (_dma_buffer_size * 3u))) {
+    _dma_band_rows++;
+  }
+
 #if defined(DEBUG_ASYNC_UPDATE)
   Serial.printf("DMA Init buf size: %d sub frames:%d spi num: %d\n", _dma_buffer_size, _dma_cnt_sub_frames_per_frame, _spi_num);
 #endif
@@ -1046,10 +1219,15 @@ void ST7735_t3::dumpDMASettings() {
 }
 
 bool ST7735_t3::updateScreenAsync(bool update_cont)         // call to say update the screen now.
+{
+  return updateScreenAsyncRows(0, _height, update_cont);
+}
+
+bool ST7735_t3::updateScreenAsyncRows(int16_t y, int16_t h, bool update_cont)
 {
   // Not sure if better here to check flag or check existence of buffer.
   // Will go by buffer as maybe can do interesting things?
-  // BUGBUG:: only handles full screen so bail on the rest of it...
+  // Only whole rows are sent, so the window is one contiguous run of the frame buffer
   // Also bail if we are working with a hardware SPI port. 
   #ifdef ENABLE_ST77XX_FRAMEBUFFER
   if (!_use_fbtft || !_pspi) return false;
@@ -1077,15 +1255,28 @@ bool ST7735_t3::updateScreenAsync(bool update_cont)         // call to say updat
 #ifdef DEBUG_ASYNC_UPDATE
   dumpDMASettings();
 #endif
+  // Round the rows out to whole bands, continuous mode always wraps to the top so it sends everything
+  int16_t y_start = (y / _dma_band_rows) * _dma_band_rows;
+  int16_t y_end = ((y + h + _dma_band_rows - 1) / _dma_band_rows) * _dma_band_rows;
+  if (update_cont || y_start < 0 || y_end > _height || (_height % _dma_band_rows)) {
+    y_start = 0;
+    y_end = _height;
+  }
+  uint32_t first_pixel = (uint32_t)y_start * _width;
+  _dma_cnt_sub_frames_per_frame = ((uint32_t)(y_end - y_start) * _width) / _dma_buffer_size;
+
   // Lets copy first parts of frame buffer into our two sub-frames
-  memcpy(_dma_data[_spi_num]._dma_buffer1, _pfbtft, _dma_buffer_size*2);
-  memcpy(_dma_data[_spi_num]._dma_buffer2, &_pfbtft[_dma_buffer_size], _dma_buffer_size*2);
-  _dma_pixel_index = _dma_buffer_size*2;
+  // The ISR keeps reading from this buffer, so setFrameBuffer() can swap in another to draw on
+  _pfbtft_async = _pfbtft;
+  _pfbtft8_async = _pfbtft8;
+  copyToDMABuffer(_dma_data[_spi_num]._dma_buffer1, first_pixel);
+  copyToDMABuffer(_dma_data[_spi_num]._dma_buffer2, first_pixel + _dma_buffer_size);
+  _dma_pixel_index = first_pixel + _dma_buffer_size*2;
   _dma_sub_frame_count = 0; // 
 
   beginSPITransaction();
-  // Doing full window. 
-  setAddr(0, 0, _width-1, _height-1);
+  // Window covering the rows being sent
+  setAddr(0, y_start, _width-1, y_end-1);
   writecommand_last(ST7735_RAMWR);
 
   // Update TCR to 16 bit mode. and output the first entry.
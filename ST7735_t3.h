@@ -132,6 +132,23 @@
 #define ST77XX_DARKGREY   0x2222
 
 
+// Glyph cache for custom font text drawn into the frame buffer. Each glyph is kept as
+// runs of set pixels per row, so drawing it is a few row fills instead of a drawPixel per bit.
+#define ST77XX_GLYPH_CACHE_ENTRIES 48   // direct mapped on font and character
+#define ST77XX_GLYPH_MAX_SPANS 96       // glyphs with more runs than this are drawn the slow way
+typedef struct {
+  int8_t  x;        // from the cursor, glyph offsets included
+  int8_t  y;
+  uint8_t len;
+} ST77XXGlyphSpan;
+
+typedef struct {
+  const GFXfont   *font;
+  uint8_t         c;
+  uint8_t         count;
+  ST77XXGlyphSpan spans[ST77XX_GLYPH_MAX_SPANS];
+} ST77XXGlyphEntry;
+
 #if defined(__IMXRT1062__)  // Teensy 4.x
 // Also define these in lower memory so as to make sure they are not cached...
 // try work around DMA memory cached.  So have a couple of buffers we copy frame buffer into
@@ -198,36 +215,49 @@ class ST7735_t3 : public Adafruit_GFX {
   // Useful methods added from ili9341_t3 
   void writeRect(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pcolors);
 
+  // Custom font text at size 1 into the frame buffer goes through the glyph cache
+  virtual size_t write(uint8_t c);
+  using Print::write;
+  uint32_t glyphCacheHits() {return _glyph_cache_hits;}
+  uint32_t glyphCacheMisses() {return _glyph_cache_misses;}
+
 // Frame buffer support
 #ifdef ENABLE_ST77XX_FRAMEBUFFER
   enum {ST77XX_DMA_INIT=0x01, ST77XX_DMA_CONT=0x02, ST77XX_DMA_FINISH=0x04,ST77XX_DMA_ACTIVE=0x80};
 
   // added support to use optional Frame buffer
   void  setFrameBuffer(uint16_t *frame_buffer);
+  void  setFrameBuffer8(uint8_t *frame_buffer);  // 8 bit palette indexed frame buffer, NULL goes back to 16 bit
+  uint8_t colorIndex(uint16_t color);   // palette entry for a colour, added on first use
   uint8_t useFrameBuffer(boolean b);    // use the frame buffer?  First call will allocate
   void  freeFrameBuffer(void);      // explicit call to release the buffer
   void  updateScreen(void);       // call to say update the screen now. 
   bool  updateScreenAsync(bool update_cont = false);  // call to say update the screen optinoally turn into continuous mode. 
+  bool  updateScreenAsyncRows(int16_t y, int16_t h, bool update_cont = false);  // only send rows y to y + h - 1, rounded out to whole DMA sub frames
   void  waitUpdateAsyncComplete(void);
   void  endUpdateAsync();      // Turn of the continueous mode fla
   void  dumpDMASettings();
   uint16_t *getFrameBuffer() {return _pfbtft;}
+  uint8_t *getFrameBuffer8() {return _pfbtft8;}
   uint32_t frameCount() {return _dma_frame_count; }
   boolean asyncUpdateActive(void)  {return (_dma_state & ST77XX_DMA_ACTIVE);}
   void  initDMASettings(void);
   #else
   // added support to use optional Frame buffer
   void  setFrameBuffer(uint16_t *frame_buffer) {return;}
+  void  setFrameBuffer8(uint8_t *frame_buffer) {return;}
   uint8_t useFrameBuffer(boolean b) {return 0;};    // use the frame buffer?  First call will allocate
   void  freeFrameBuffer(void) {return;}      // explicit call to release the buffer
   void  updateScreen(void) {return;}       // call to say update the screen now. 
   bool  updateScreenAsync(bool update_cont = false) {return false;}  // call to say update the screen optinoally turn into continuous mode. 
+  bool  updateScreenAsyncRows(int16_t y, int16_t h, bool update_cont = false) {return false;}
   void  waitUpdateAsyncComplete(void) {return;}
   void  endUpdateAsync() {return;}      // Turn of the continueous mode fla
   void  dumpDMASettings() {return;}
 
   uint32_t frameCount() {return 0; }
   uint16_t *getFrameBuffer() {return NULL;}
+  uint8_t *getFrameBuffer8() {return NULL;}
   boolean asyncUpdateActive(void)  {return false;}
   #endif
 
@@ -235,6 +265,12 @@ class ST7735_t3 : public Adafruit_GFX {
  protected:
   uint8_t  tabcolor;
 
+  static ST77XXGlyphEntry _glyph_cache[ST77XX_GLYPH_CACHE_ENTRIES];
+  static bool     _glyph_cache_ready;
+  static uint32_t _glyph_cache_hits;
+  static uint32_t _glyph_cache_misses;
+  const ST77XXGlyphEntry *glyphCacheLookup(const GFXfont *font, uint8_t c);
+
   void     spiwrite(uint8_t),
            spiwrite16(uint16_t d),
            writecommand(uint8_t c),
@@ -369,6 +405,14 @@ class ST7735_t3 : public Adafruit_GFX {
 #ifdef ENABLE_ST77XX_FRAMEBUFFER
     // Add support for optional frame buffer
   uint16_t  *_pfbtft;           // Optional Frame buffer 
+  uint16_t  *_pfbtft_async;     // Frame buffer the DMA update is sending, drawing may move on to another
+  uint8_t   *_pfbtft8;          // Optional 8 bit frame buffer, used instead of _pfbtft when set
+  uint8_t   *_pfbtft8_async;
+  uint16_t  _palette[256];      // RGB565 for each 8 bit pixel value, entries are only ever added
+  uint16_t  _palette_count;
+  uint16_t  _palette_last_color;  // most drawing repeats the same colour
+  uint8_t   _palette_last_index;
+  void      copyToDMABuffer(uint16_t *dma_buffer, uint32_t pixel_index);
   uint8_t   _use_fbtft;         // Are we in frame buffer mode?
   uint16_t  *_we_allocated_buffer;      // We allocated the buffer; 
   uint32_t  _count_pixels;       // How big is the display in total pixels...
@@ -393,6 +437,7 @@ class ST7735_t3 : public Adafruit_GFX {
   volatile uint16_t _dma_sub_frame_count = 0; // Can return a frame count...
   uint16_t          _dma_buffer_size;   // the actual size we are using <= DMA_BUFFER_SIZE;
   uint16_t          _dma_cnt_sub_frames_per_frame;  
+  uint16_t          _dma_band_rows;     // smallest run of rows that is a whole number of sub frames (at least 3)
   uint32_t      _spi_fcr_save;    // save away previous FCR register value
 
   #elif defined(__MK64FX512__)
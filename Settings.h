@@ -7,7 +7,7 @@ void settingsUpdateParams();
 void settingsSendNotes();
 void settingsLEDintensity();
 void settingsSLIDERintensity();
-//void settingsCCType();
+void settingsCCType();
 
 int currentIndexMIDICh();
 int currentIndexMIDIOutCh();
@@ -16,7 +16,7 @@ int currentIndexUpdateParams();
 int currentIndexSendNotes();
 int currentIndexLEDintensity();
 int currentIndexSLIDERintensity();
-//int currentIndexCCType();
+int currentIndexCCType();
 
 void settingsMIDICh(int index, const char *value) {
   if (strcmp(value, "ALL") == 0) {
@@ -70,6 +70,7 @@ void settingsUpdateParams(int index, const char *value) {
     updateParams =  false;
   }
   storeUpdateParams(updateParams ? 1 : 0);
+  midiRouteApplySettings();
 }
 
 void settingsSendNotes(int index, const char *value) {
@@ -79,22 +80,17 @@ void settingsSendNotes(int index, const char *value) {
     sendNotes =  false;
   }
   storeSendNotes(sendNotes ? 1 : 0);
+  midiRouteApplySettings();
 }
 
-// void settingsCCType(int index, const char *value) {
-//   if (strcmp(value, "CC") == 0 ) {
-//     ccType = 0;
-//   } else {
-//     if (strcmp(value , "NRPN") == 0 ) {
-//       ccType = 1;
-//     } else {
-//       if (strcmp(value , "SYSEX") == 0 ) {
-//         ccType = 2;
-//       }
-//     }
-//   }
-//   storeCCType(ccType);
-// }
+void settingsCCType(int index, const char *value) {
+  if (strcmp(value, "Some High Res") == 0) {
+    ccType = CC_TYPE_HIRES;
+  } else {
+    ccType = CC_TYPE_CC;
+  }
+  storeCCType(ccType);
+}
 
 int currentIndexMIDICh() {
   return getMIDIChannel();
@@ -124,9 +120,9 @@ int currentIndexSendNotes() {
   return getSendNotes() ? 1 : 0;
 }
 
-// int currentIndexCCType() {
-//   return getCCType();
-// }
+int currentIndexCCType() {
+  return getCCType() == CC_TYPE_HIRES ? 1 : 0;
+}
 
 // add settings to the circular buffer
 void setUpSettings() {
@@ -135,4 +131,5 @@ void setUpSettings() {
   settings::append(settings::SettingsOption{"Encoder", {"Type 1", "Type 2", "\0"}, settingsEncoderDir, currentIndexEncoderDir});
   settings::append(settings::SettingsOption{"USB Params", {"Off", "Send Params", "\0"}, settingsUpdateParams, currentIndexUpdateParams});
   settings::append(settings::SettingsOption{"USB Notes", {"Off", "Send Notes", "\0"}, settingsSendNotes, currentIndexSendNotes});
+  settings::append(settings::SettingsOption{"CC Type", {"CC", "Some High Res", "\0"}, settingsCCType, currentIndexCCType});
 }
@@ -0,0 +1,42 @@
+// Batched USB device MIDI output
+//
+// Every message to the host goes through these instead of straight to usbMIDI. usbMIDI
+// only adds a packet to its transmit buffer, the Teensy core sends partly filled transfers
+// from its own timer, so messages from one loop() pass can be split over several transfers.
+// usbOutFlush() at the end of loop() sends the whole pass with a single send_now().
+
+static uint16_t usbOutPacketsThisFrame = 0;  // packets queued since the last flush
+static uint16_t usbOutPacketsMaxFrame = 0;   // largest batch so far
+static uint32_t usbOutPacketsTotal = 0;
+static uint32_t usbOutFrames = 0;            // flushes that had something to send
+
+inline void usbOutControlChange(byte cc, byte value, byte channel) {
+  usbMIDI.sendControlChange(cc, value, channel);
+  usbOutPacketsThisFrame++;
+}
+
+inline void usbOutNoteOn(byte note, byte velocity, byte channel) {
+  usbMIDI.sendNoteOn(note, velocity, channel);
+  usbOutPacketsThisFrame++;
+}
+
+inline void usbOutNoteOff(byte note, byte velocity, byte channel) {
+  usbMIDI.sendNoteOff(note, velocity, channel);
+  usbOutPacketsThisFrame++;
+}
+
+// Any channel message, type is the status without the channel
+inline void usbOutSend(byte type, byte data1, byte data2, byte channel) {
+  usbMIDI.send(type, data1, data2, channel, 0);
+  usbOutPacketsThisFrame++;
+}
+
+// Sends everything queued this loop() pass, call once at the end of loop()
+void usbOutFlush() {
+  if (usbOutPacketsThisFrame == 0) return;
+  usbMIDI.send_now();
+  usbOutFrames++;
+  usbOutPacketsTotal += usbOutPacketsThisFrame;
+  if (usbOutPacketsThisFrame > usbOutPacketsMaxFrame) usbOutPacketsMaxFrame = usbOutPacketsThisFrame;
+  usbOutPacketsThisFrame = 0;
+}